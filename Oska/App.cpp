@@ -74,6 +74,10 @@ Point OutBox::randomPoint ( ) const noexcept {
 
 void App::initialize ( const std::int32_t no_stones_ ) {
 	m_state.initialize ( no_stones_ );
+	m_state.visit ( [ this ] ( const auto & state_ ) {
+		m_agent_search = std::make_unique<AgentSearch<std::decay_t<decltype ( state_ )>>> ( );
+	} );
+	tb::load ( no_stones_, g_app_data_path ); // Play-outs are exact from the tablebase on, if there is one.
 	const ResourceData resource_data ( no_stones_ );
 	// Setup parameters.
 	m_window_width = resource_data.m_xara_dim.x;
@@ -137,6 +141,7 @@ void App::initialize ( const std::int32_t no_stones_ ) {
 	m_agent_stone_mover.initialize ( m_state );
 	m_agent_stone_captor.initialize ( m_state, m_agent_outbox );
 	m_human_stone_captor.initialize ( m_state, m_human_outbox );
+	ponder ( );
 }
 
 
@@ -270,6 +275,11 @@ void App::updateBoard ( ) noexcept {
 
 void App::updateWindow ( ) noexcept {
 
+	if ( m_agent_move.valid ( ) and m_agent_move.wait_for ( std::chrono::seconds ( 0 ) ) == std::future_status::ready ) {
+
+		doAgentMctsMove ( );
+	}
+
 	updateBoard ( );
 
 	m_window.draw ( m_board );
@@ -332,9 +342,20 @@ void App::doAgentRandomMove ( ) noexcept {
 }
 
 
+void App::startAgentMctsMove ( ) {
+
+	// The search is instantiated for the board size of m_state, it continues the tree of the
+	// game, with what was pondered in the subtree of the human's move. The move is done by
+	// updateWindow ( ), once the search has it (see doAgentMctsMove ( )).
+	m_agent_move = m_state.visit ( [ this ] ( const auto & state_ ) {
+		return std::get<std::unique_ptr<AgentSearch<std::decay_t<decltype ( state_ )>>>> ( m_agent_search )->start ( state_, agent_budget );
+	} );
+}
+
+
 void App::doAgentMctsMove ( ) noexcept {
 
-	const Move agent_move = mcts::Mcts<os::OskaState>::compute ( m_state );
+	const Move agent_move = m_agent_move.get ( );
 
 	if ( agent_move not_eq Move::invalid ) {
 
@@ -345,6 +366,7 @@ void App::doAgentMctsMove ( ) noexcept {
 
 		m_agent_stone_mover.start ( agent_move, 0.25f );
 		m_state.doMove ( agent_move );
+		ponder ( );
 
 		return;
 	}
@@ -354,6 +376,18 @@ void App::doAgentMctsMove ( ) noexcept {
 }
 
 
+void App::ponder ( ) noexcept {
+
+	// The agent searches on, from the position the human is to move in, until the human's move
+	// (see startAgentMctsMove ( )).
+	m_state.visit ( [ this ] ( const auto & state_ ) {
+		if ( state_.playerToMove ( ) == Player::Type::human ) {
+			std::get<std::unique_ptr<AgentSearch<std::decay_t<decltype ( state_ )>>>> ( m_agent_search )->ponder ( state_ );
+		}
+	} );
+}
+
+
 void App::mouse ( ) {
 
 	static Point point, offset, previous_mouse_point;
@@ -401,6 +435,11 @@ void App::mouse ( ) {
 
 		if ( not ( m_is_dragging ) ) {
 
+			if ( m_agent_move.valid ( ) ) { // The agent is thinking.
+
+				return;
+			}
+
 			m_human_id_from = m_state.pointToHumanID ( m_mouse_point );
 
 			if ( not ( m_state.isValidID ( m_human_id_from ) ) ) {
@@ -454,9 +493,9 @@ void App::mouse ( ) {
 
 			m_human_id_to = m_state.pointToHexID ( point );
 
-			if ( m_state.isValidID ( m_human_id_to ) and doHumanMove ( point ) ) { // If Human move successfull do agent move.
+			if ( m_state.isValidID ( m_human_id_to ) and doHumanMove ( point ) ) { // If Human move successfull start the agent's move.
 
-				doAgentMctsMove ( );
+				startAgentMctsMove ( );
 			}
 
 			m_human_id_from = m_human_id_to = Location::invalid;
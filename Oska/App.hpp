@@ -23,6 +23,10 @@
 
 #pragma once
 
+#include <chrono>
+#include <future>
+#include <memory>
+#include <variant>
 #include <vector>
 
 #include <boost/container/static_vector.hpp>
@@ -33,6 +37,7 @@
 
 #include "Oska.hpp"
 #include "Mcts.hpp"
+#include "AsyncSearch.hpp"
 
 
 class OutBox {
@@ -169,10 +174,25 @@ struct Captor {
 };
 
 
+template< typename State >
+using AgentSearch = mcts::AsyncSearch < State, mcts::Mcts < State, true > >; // Reflected positions share a node.
+
+
 class App {
 
     os::OskaState m_state;
 
+    // The search of the agent, of the board size of m_state, is kept for the game, it ponders
+    // during the human's turn. The agent's move is searched for in the background, the window
+    // is updated meanwhile, m_agent_move is valid while the agent is thinking.
+
+    std::variant < std::unique_ptr < AgentSearch < OskaStateTemplate < 4 > > >, std::unique_ptr < AgentSearch < OskaStateTemplate < 5 > > >, std::unique_ptr < AgentSearch < OskaStateTemplate < 6 > > >,
+        std::unique_ptr < AgentSearch < OskaStateTemplate < 7 > > >, std::unique_ptr < AgentSearch < OskaStateTemplate < 8 > > > > m_agent_search;
+
+    std::future<Move> m_agent_move;
+
+    static constexpr std::chrono::milliseconds agent_budget { 1'000 };
+
     std::vector<Point> m_board_polygon;
 
 public:
@@ -279,7 +299,9 @@ private:
 
     bool doHumanMove ( const Point point_ ) noexcept;
     void doAgentRandomMove ( ) noexcept;
+    void startAgentMctsMove ( );
     void doAgentMctsMove ( ) noexcept;
+    void ponder ( ) noexcept;
 
 public:
 
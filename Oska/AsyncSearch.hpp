@@ -0,0 +1,122 @@
+
+// MIT License
+//
+// Copyright (c) 2018 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <utility>
+
+#include "Typedefs.hpp"
+#include "Mcts.hpp"
+
+
+namespace mcts {
+
+    // The search service of one game, start ( ) returns at once with the future of the agent's
+    // move, the search runs on a thread of its own. stop ( ) cuts it short (the future then has
+    // the best move so far), poll ( ) tells how far it got. The tree is kept from move to move,
+    // and in between moves ponder ( ) searches on during the human's turn. The searches of
+    // different games (of different AsyncSearch's) are independent.
+
+    template<typename State, typename Mcts = mcts::Mcts<State, true>>
+    class AsyncSearch {
+
+    public:
+
+        typedef typename State::Move Move;
+        typedef typename Mcts::Clock Clock;
+
+        struct Progress {
+            index_t m_no_iterations; // Of the search (or of the pondering) in progress, or of the last one.
+            bool m_is_ready;         // The future of the last start ( ) has its move.
+        };
+
+    private:
+
+        Mcts m_mcts;
+        std::thread m_thread;
+        std::atomic < bool > m_is_ready { true };
+        const index_t m_no_threads; // Of a Locking Mcts, 0 is one per processor.
+
+        void join ( ) noexcept {
+            if ( m_thread.joinable ( ) ) {
+                m_thread.join ( );
+            }
+        }
+
+    public:
+
+        explicit AsyncSearch ( const index_t no_threads_ = 0 ) noexcept :
+            m_no_threads ( no_threads_ ) {
+        }
+
+        AsyncSearch ( const AsyncSearch & ) = delete;
+        AsyncSearch & operator = ( const AsyncSearch & ) = delete;
+
+        ~AsyncSearch ( ) noexcept {
+            stop ( );
+            join ( );
+        }
+
+        // The search of the move of state_ (continuing the tree of the game), for the budget_, a
+        // search still in progress is stopped first (its future gets its move).
+
+        [[ nodiscard ]] std::future<Move> start ( const State & state_, const typename Clock::duration budget_ ) {
+            stop ( );
+            join ( );
+            m_mcts.stopPondering ( );
+            m_is_ready.store ( false, std::memory_order_relaxed );
+            std::promise<Move> promise;
+            std::future<Move> move = promise.get_future ( );
+            m_thread = std::thread ( [ this, state_, budget_, promise = std::move ( promise ) ] ( ) mutable {
+                promise.set_value ( m_mcts.compute ( state_, budget_, m_no_threads ) );
+                m_is_ready.store ( true, std::memory_order_release );
+            } );
+            return move;
+        }
+
+        // Ends the search in progress early, it does not wait for it, the future has the move
+        // after at least one iteration. Pondering is ended by the next start ( ) only.
+
+        void stop ( ) noexcept {
+            if ( not ( m_is_ready.load ( std::memory_order_acquire ) ) ) {
+                m_mcts.stop ( );
+            }
+        }
+
+        [[ nodiscard ]] Progress poll ( ) const noexcept {
+            return { m_mcts.m_progress.load ( std::memory_order_relaxed ), m_is_ready.load ( std::memory_order_acquire ) };
+        }
+
+        // Searches on from state_ (the position after the agent's move), until the next start ( ),
+        // see Mcts::startPondering ( ).
+
+        void ponder ( const State & state_ ) {
+            join ( );
+            m_mcts.startPondering ( state_ );
+        }
+    };
+}
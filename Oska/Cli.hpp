@@ -0,0 +1,270 @@
+
+// MIT License
+//
+// Copyright (c) 2018 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Typedefs.hpp"
+#include "Globals.hpp"
+#include "Oska.hpp"
+#include "Mcts.hpp"
+#include "Perft.hpp"
+#include "Solver.hpp"
+
+
+// The command line modes, without a window, of the app (Main.cpp) and of the headless driver
+// (OskaCli.cpp, built with OSKA_HEADLESS, without SFML and Win32). The arguments exclude the
+// program name, the mode is the first.
+
+namespace cli {
+
+    enum class Parallel : index_t { tree, root, leaf };
+
+    // Games of the search (as the app plays it, a new tree per move) as agent, against uniformly
+    // random moves as human, who moves first alternates, reports the score and the speed. More
+    // than 1 thread (0 is one per processor) search the locking tree in parallel, or a tree each
+    // (merged), or share the play-outs of a leaf, of which there are playouts_ per leaf. With
+    // milliseconds_ (not root parallel), a move is searched for that long, instead of iterations_.
+
+    template<index_t S>
+    void search ( const index_t iterations_, const index_t milliseconds_, const index_t games_, const index_t threads_, const Parallel parallel_, const index_t playouts_ ) {
+        using State = OskaStateTemplate<S>;
+        using ParallelMcts = mcts::Mcts<State, true, typename State::PlayoutPolicy, true>;
+        constexpr const char * parallel [ 3 ] = { ", tree parallel", ", root parallel", ", leaf parallel" };
+        if ( milliseconds_ ) {
+            std::printf ( "\nOska %i, search of %i ms per move (%i threads%s, %i play-outs per leaf) against random moves, %i games\n\n", S, milliseconds_, threads_, 1 == threads_ ? "" : parallel [ ( index_t ) parallel_ ], playouts_, games_ );
+        }
+        else {
+            std::printf ( "\nOska %i, search of %i iterations per move (%i threads%s, %i play-outs per leaf) against random moves, %i games\n\n", S, iterations_, threads_, 1 == threads_ ? "" : parallel [ ( index_t ) parallel_ ], playouts_, games_ );
+        }
+        const std::chrono::milliseconds budget ( milliseconds_ );
+        // The iterations of a move, of the budget if timed.
+        const auto compute = [ & ] ( auto * mcts_, const State & state_, const index_t threads_ ) {
+            const Move move = milliseconds_ ? mcts_->compute ( state_, budget, threads_ ) : mcts_->compute ( state_, iterations_, threads_ );
+            const index_t iterations = mcts_->m_no_iterations;
+            delete mcts_;
+            return std::make_pair ( move, iterations );
+        };
+        double score = 0.0, seconds = 0.0;
+        std::int64_t moves = 0, iterations = 0;
+        for ( index_t g = 0; g < games_; ++g ) {
+            State state;
+            state.initialize ( g % 2 ? Player::Type::human : Player::Type::agent );
+            while ( not ( state.ended ( ) ) ) {
+                if ( state.playerToMove ( ) == Player::Type::agent ) {
+                    const auto start = std::chrono::steady_clock::now ( );
+                    std::pair<Move, index_t> move;
+                    if ( 1 == threads_ or Parallel::leaf == parallel_ ) {
+                        mcts::Mcts<State, true> * mcts = new mcts::Mcts<State, true> ( );
+                        mcts->setPlayouts ( playouts_, threads_ );
+                        move = compute ( mcts, state, 1 );
+                    }
+                    else if ( Parallel::root == parallel_ ) {
+                        move = { mcts::Mcts<State, true>::computeRootParallel ( state, iterations_, threads_, playouts_ ), iterations_ };
+                    }
+                    else {
+                        ParallelMcts * mcts = new ParallelMcts ( );
+                        mcts->setPlayouts ( playouts_ );
+                        move = compute ( mcts, state, threads_ );
+                    }
+                    state.move_hash_winner ( move.first );
+                    iterations += move.second;
+                    seconds += std::chrono::duration<double> ( std::chrono::steady_clock::now ( ) - start ).count ( );
+                    ++moves;
+                }
+                else {
+                    state.move_hash_winner ( state.randomMove ( ) );
+                }
+            }
+            const Player winner = * state.ended ( );
+            score += winner.vacant ( ) ? 0.5 : ( winner == Player::Type::agent ? 1.0 : 0.0 );
+        }
+        std::printf ( " score %.1f%%, %.3f s per move, %.0f iterations/s\n", 100.0 * score / games_, seconds / moves, iterations / seconds );
+    }
+
+    [[ maybe_unused ]] inline bool search ( const index_t size_, const index_t iterations_, const index_t milliseconds_, const index_t games_, const index_t threads_, const Parallel parallel_, const index_t playouts_ ) {
+        if ( milliseconds_ and Parallel::root == parallel_ ) {
+            std::printf ( "The root parallel search has no time budget.\n" );
+            return false;
+        }
+        switch ( size_ ) {
+            case 4: search<4> ( iterations_, milliseconds_, games_, threads_, parallel_, playouts_ ); return true;
+            case 5: search<5> ( iterations_, milliseconds_, games_, threads_, parallel_, playouts_ ); return true;
+            case 6: search<6> ( iterations_, milliseconds_, games_, threads_, parallel_, playouts_ ); return true;
+            case 7: search<7> ( iterations_, milliseconds_, games_, threads_, parallel_, playouts_ ); return true;
+            case 8: search<8> ( iterations_, milliseconds_, games_, threads_, parallel_, playouts_ ); return true;
+            default: return false;
+        }
+    }
+
+
+    // Transposition table benchmark, threads_ threads (0 is one per processor) insert-or-get (as
+    // the expansion of a node does) and then look up the same 2^log2_keys_ keys, each in an order
+    // of its own, all keys are contended for. The lock-free rt::TranspositionTable (grown from its
+    // default capacity, and reserved) against tbb::concurrent_unordered_map. A key added by more
+    // than one thread fails the benchmark.
+
+    inline bool transpositions ( index_t threads_, const index_t log2_keys_ ) {
+        using State = OskaStateTemplate<5>;
+        using Tree = typename mcts::Mcts<State, true, typename State::PlayoutPolicy, true>::Tree;
+        using Node = typename Tree::Node;
+        if ( threads_ < 1 ) {
+            threads_ = std::max ( 1, ( index_t ) getNumberOfProcessors ( ) );
+        }
+        const std::size_t no_keys = std::size_t { 1 } << log2_keys_;
+        std::vector<ZobristHash> keys ( no_keys );
+        std::mt19937_64 rng ( 1 );
+        for ( ZobristHash & key : keys ) {
+            key = rng ( );
+        }
+        std::printf ( "\nTransposition table, %i threads, %zu keys\n\n", threads_, no_keys );
+        // Thread t_ visits the keys in the order of the odd multiplier 2 t_ + 1 (of a power of 2).
+        const auto run = [ & ] ( auto && work_ ) {
+            std::atomic<index_t> ready { 0 };
+            std::vector<std::thread> threads;
+            const auto start = std::chrono::steady_clock::now ( );
+            for ( index_t t = 0; t < threads_; ++t ) {
+                threads.emplace_back ( [ &, t ] ( ) {
+                    ready.fetch_add ( 1, std::memory_order_relaxed );
+                    while ( ready.load ( std::memory_order_relaxed ) < threads_ ) {
+                        std::this_thread::yield ( );
+                    }
+                    for ( std::size_t i = 0; i < no_keys; ++i ) {
+                        const std::size_t k = ( i * ( 2 * t + 1 ) + t ) & ( no_keys - 1 );
+                        work_ ( keys [ k ], ( index_t ) k );
+                    }
+                } );
+            }
+            for ( std::thread & thread : threads ) {
+                thread.join ( );
+            }
+            return threads_ * no_keys / ( 1'000'000.0 * std::chrono::duration<double> ( std::chrono::steady_clock::now ( ) - start ).count ( ) );
+        };
+        bool success = true;
+        const auto report = [ & ] ( const char * name_, const double inserts_, const double gets_, const std::size_t added_, const std::size_t found_ ) {
+            std::printf ( " %-32s insert-or-get %7.1f Mops/s, look-up %7.1f Mops/s%s\n", name_, inserts_, gets_, added_ == no_keys and found_ == threads_ * no_keys ? "" : ", FAILED" );
+            success = success and added_ == no_keys and found_ == threads_ * no_keys;
+        };
+        for ( const bool reserved : { false, true } ) {
+            rt::TranspositionTable<Tree, ZobristHash, Node, true> table;
+            if ( reserved ) {
+                table.reserve ( no_keys );
+            }
+            std::atomic<std::size_t> added { 0 }, found { 0 };
+            const double inserts = run ( [ & ] ( const ZobristHash key_, const index_t k_ ) {
+                if ( table.insert_or_get ( key_, [ k_ ] ( ) { return Node ( k_ ); } ).second ) {
+                    added.fetch_add ( 1, std::memory_order_relaxed );
+                }
+            } );
+            const double gets = run ( [ & ] ( const ZobristHash key_, const index_t k_ ) {
+                if ( table.get ( key_ ) == Node ( k_ ) ) {
+                    found.fetch_add ( 1, std::memory_order_relaxed );
+                }
+            } );
+            report ( reserved ? "rt::TranspositionTable, reserved" : "rt::TranspositionTable", inserts, gets, added, found );
+        }
+        {
+            tbb::concurrent_unordered_map<ZobristHash, Node> table;
+            std::atomic<std::size_t> added { 0 }, found { 0 };
+            const double inserts = run ( [ & ] ( const ZobristHash key_, const index_t k_ ) {
+                if ( table.insert ( std::make_pair ( key_, Node ( k_ ) ) ).second ) {
+                    added.fetch_add ( 1, std::memory_order_relaxed );
+                }
+            } );
+            const double gets = run ( [ & ] ( const ZobristHash key_, const index_t k_ ) {
+                const auto it = table.find ( key_ );
+                if ( it != table.end ( ) and it->second == Node ( k_ ) ) {
+                    found.fetch_add ( 1, std::memory_order_relaxed );
+                }
+            } );
+            report ( "tbb::concurrent_unordered_map", inserts, gets, added, found );
+        }
+        return success;
+    }
+
+
+    inline void usage ( ) noexcept {
+        std::printf ( "usage: Oska perft [depth [size [divide]]]\n"
+                      "       Oska tablebase size [stones]\n"
+                      "       Oska solve [size [threads [log2 table size]]]\n"
+                      "       Oska playout [size [milliseconds per move [games]]]\n"
+                      "       Oska search [size [iterations|milliseconds per move, as 250ms [games [threads [tree|root|leaf [play-outs per leaf]]]]]]\n"
+                      "       Oska transpositions [threads [log2 keys]]\n" );
+    }
+
+
+    // The exit code of the mode, none if args_ name no mode.
+
+    [[ nodiscard ]] inline std::optional<std::int32_t> run ( const std::vector<std::string> & args_ ) {
+        const std::size_t argc = args_.size ( );
+        const auto arg = [ & args_ ] ( const std::size_t i_, const index_t default_ ) {
+            return i_ < args_.size ( ) ? ( index_t ) std::stoi ( args_ [ i_ ] ) : default_;
+        };
+        const auto exit_code = [ ] ( const bool success_ ) {
+            return success_ ? EXIT_SUCCESS : EXIT_FAILURE;
+        };
+        if ( not ( argc ) ) {
+            return { };
+        }
+        // Perft, size 0 (default) runs all sizes.
+        if ( "perft" == args_ [ 0 ] ) {
+            return exit_code ( pf::run ( arg ( 2, 0 ), arg ( 1, 5 ), argc > 3 ) );
+        }
+        // Endgame tablebase generation, written to the app-data directory.
+        if ( argc > 1 and "tablebase" == args_ [ 0 ] ) {
+            const index_t size = arg ( 1, 0 );
+            return exit_code ( tb::generate ( size, arg ( 2, tb::defaultMaxStones ( size ) ), g_app_data_path ) );
+        }
+        // Exact solution of the initial position, 0 threads is one per processor.
+        if ( "solve" == args_ [ 0 ] ) {
+            return exit_code ( sv::run ( arg ( 1, 4 ), arg ( 2, 0 ), arg ( 3, 24 ) ) );
+        }
+        // Play-out policy benchmark.
+        if ( "playout" == args_ [ 0 ] ) {
+            return exit_code ( po::run ( arg ( 1, 5 ), arg ( 2, 50 ), arg ( 3, 100 ) ) );
+        }
+        // Search against random moves, 0 threads is one per processor, tree parallel by default,
+        // the budget of a move is iterations, or milliseconds (with an ms suffix).
+        if ( "search" == args_ [ 0 ] ) {
+            const Parallel parallel = argc > 5 and "root" == args_ [ 5 ] ? Parallel::root : ( argc > 5 and "leaf" == args_ [ 5 ] ? Parallel::leaf : Parallel::tree );
+            const bool timed = argc > 2 and args_ [ 2 ].size ( ) > 2 and 0 == args_ [ 2 ].compare ( args_ [ 2 ].size ( ) - 2, 2, "ms" );
+            return exit_code ( search ( arg ( 1, 5 ), timed ? 0 : arg ( 2, 100'000 ), timed ? arg ( 2, 0 ) : 0, arg ( 3, 10 ), arg ( 4, 1 ), parallel, arg ( 6, 10 ) ) );
+        }
+        // Concurrent transposition table benchmark, 0 threads is one per processor.
+        if ( "transpositions" == args_ [ 0 ] ) {
+            return exit_code ( transpositions ( arg ( 1, 0 ), arg ( 2, 20 ) ) );
+        }
+        return { };
+    }
+}
@@ -21,7 +21,12 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+// The globals of the app and of the headless driver (OskaCli.cpp), with OSKA_HEADLESS defined
+// without SFML and Win32.
+
+#if not defined ( OSKA_HEADLESS )
 #include <Windows.h>
+#endif
 
 #include <cstdlib>
 
@@ -44,25 +49,54 @@ Does #define BOOST_SP_USE_STD_ATOMIC work for clang-cl and clang/c2?
 */
 
 
+#include <algorithm>
 #include <filesystem>
+#include <mutex>
 #include <random>
+#include <string>
+#include <thread>
 
 namespace fs = std::filesystem;
 
 
+#if not defined ( OSKA_HEADLESS )
+
 #include <SFML/Graphics.hpp>
 
-#include "splitmix.hpp"
+sf::Clock g_clock;
 
+#endif
+
+#include "splitmix.hpp"
 
-sf::Clock g_clock;
 
 using rng_t = splitmix64;
 
-rng_t g_rng ( 1234567890 );
+// The first thread draws from the stream seeded 1234567890, the other threads from streams split
+// off (with a seed and a gamma of their own) from a generator seeded the same.
+
+rng_t rngStream ( ) noexcept {
+
+	static std::mutex mutex;
+	static rng_t rng ( 1234567890 );
+	static bool is_first = true;
+
+	std::lock_guard < std::mutex > lock ( mutex );
 
+	if ( is_first ) {
 
-std::bernoulli_distribution g_bernoulli_distribution;
+		is_first = false;
+
+		return rng_t ( 1234567890 );
+	}
+
+	return rng.split ( );
+}
+
+thread_local rng_t g_rng ( rngStream ( ) );
+
+
+thread_local std::bernoulli_distribution g_bernoulli_distribution;
 
 
 bool bernoulli ( ) noexcept {
@@ -72,6 +106,36 @@ bool bernoulli ( ) noexcept {
 
 
 
+#if defined ( OSKA_HEADLESS )
+
+fs::path appDataPath ( std::string && name_ ) {
+
+	const char * value = std::getenv ( "HOME" );
+
+	fs::path return_value ( fs::path ( value ? value : "." ) / ( "." + name_ ) );
+
+	fs::create_directory ( return_value ); // No error if directory exists.
+
+	return return_value;
+}
+
+const fs::path app_data_path_ = appDataPath ( "oska" );
+
+fs::path & g_app_data_path = const_cast < fs::path & > ( app_data_path_ );
+
+
+const fs::path app_path_ = fs::current_path ( );
+
+fs::path & g_app_path = const_cast < fs::path & > ( app_path_ );
+
+
+std::int32_t getNumberOfProcessors ( ) noexcept {
+
+	return std::max ( 1, ( std::int32_t ) std::thread::hardware_concurrency ( ) );
+}
+
+#else
+
 fs::path appDataPath ( std::string && name_ ) {
 
 	char *value;
@@ -114,3 +178,5 @@ std::int32_t getNumberOfProcessors ( ) noexcept {
 
 	return std::atoi ( value );
 }
+
+#endif
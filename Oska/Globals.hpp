@@ -54,17 +54,28 @@ extern fs::path & g_app_data_path; // This needs to be in header file.
 extern fs::path & g_app_path;
 
 
+// With OSKA_HEADLESS defined, the engine (the rules, the searches and their trees) builds
+// without SFML and Win32, the GUI needs SFML's clock.
+
+#if not defined ( OSKA_HEADLESS )
+
 #include <SFML/Graphics.hpp>
 
 extern sf::Clock g_clock;
 
+#endif
+
 using rng_t = splitmix64;
 
-extern rng_t g_rng;
+// Every thread draws from a stream of its own (the searches are multi-threaded).
+
+extern thread_local rng_t g_rng;
 
 bool bernoulli ( ) noexcept;
 
 
+#if not defined ( OSKA_HEADLESS )
+
 sf::Time now ( ) noexcept {
 
 	return g_clock.getElapsedTime ( );
@@ -75,8 +86,10 @@ sf::Time since ( const sf::Time start_ ) noexcept {
 	return g_clock.getElapsedTime ( ) - start_;
 }
 
+#endif
+
 
-void sleep ( const sf::Int32 milliseconds_ ) noexcept {
+void sleep ( const std::int32_t milliseconds_ ) noexcept {
 
 	std::this_thread::sleep_for ( std::chrono::milliseconds ( milliseconds_ ) );
 }
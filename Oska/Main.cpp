@@ -23,13 +23,17 @@
 
 #include <iostream>
 #include <exception>
+#include <optional>
 #include <stdexcept>
+#include <string>
+#include <vector>
 
 #include "Globals.hpp"
 #include "Text.hpp"
 #include "App.hpp"
 #include "Oska.hpp"
 #include "Typedefs.hpp"
+#include "Cli.hpp"
 
 
 void handleEptr ( std::exception_ptr eptr ) { // Passing by value is ok.
@@ -44,7 +48,7 @@ void handleEptr ( std::exception_ptr eptr ) { // Passing by value is ok.
 }
 
 
-std::int32_t wmain ( ) {
+std::int32_t wmain ( std::int32_t argc_, wchar_t * argv_ [ ] ) {
 
 	std::int32_t no_stones = 8;
 
@@ -52,6 +56,23 @@ std::int32_t wmain ( ) {
 
 	try {
 
+		// The modes without a window (see Cli.hpp), e.g. "Oska perft [depth [size [divide]]]".
+
+		if ( argc_ > 1 ) {
+
+			std::vector<std::string> args;
+
+			for ( std::int32_t i = 1; i < argc_; ++i ) {
+
+				args.emplace_back ( fs::path ( argv_ [ i ] ).string ( ) );
+			}
+
+			if ( const std::optional<std::int32_t> exit_code = cli::run ( args ); exit_code ) {
+
+				return * exit_code;
+			}
+		}
+
 		// Create the app (contains the window).
 
 		std::unique_ptr<App> app_uptr = std::make_unique<App> ( );
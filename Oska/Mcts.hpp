@@ -23,19 +23,24 @@
 
 #pragma once
 
+#include <cassert>
 #include <cstdint>
 #include <cstdlib>
 #include <cmath>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <iostream>
 #include <random>
-#include <unordered_map>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include <boost/dynamic_bitset.hpp>
 #include <boost/container/static_vector.hpp>
 
 #include <cereal/cereal.hpp>
-#include <cereal/types/unordered_map.hpp>
 #include <cereal/archives/binary.hpp>
 
 #include "owningptr.hpp"
@@ -43,6 +48,7 @@
 
 #include "Typedefs.hpp"
 #include "stable_rooted_digraph-1.2.hpp"
+#include "PlayoutPool.hpp"
 
 
 namespace mcts {
@@ -108,7 +114,7 @@ namespace mcts {
         // float m_score = 0.0f; // 4 bytes.
         // std::int32_t m_visits = 0; // 4 bytes.
 
-        typename State::Move m_move = State::Move::invalid; // 1 bytes.
+        typename State::CompactMove m_move = State::CompactMove::invalid; // 1 bytes.
 
         // Constructors.
 
@@ -118,7 +124,12 @@ namespace mcts {
 
         ArcData ( const State & state_ ) noexcept {
             // std::cout << "arcdata constructed from state\n";
-            m_move = state_.lastMove ( );
+            m_move = State::compact ( state_.lastMove ( ) );
+        }
+
+        ArcData ( const State &, const typename State::CompactMove move_ ) noexcept {
+            // The move in the orientation of the source node (see Mcts), set before the arc is linked.
+            m_move = move_;
         }
 
         ArcData ( const ArcData & ad_ ) noexcept {
@@ -169,19 +180,78 @@ namespace mcts {
     };
 
 
+    // The statistics of a node, the visits (the low half) and the score (the high half, in fixed
+    // point, 1 / score_scale) packed in one 64-bit atomic word. An update is a single fetch_add ( ),
+    // a load ( ) is a consistent snapshot, the threads of a parallel search need no node locks
+    // for them. The score (of at most max_visits play-outs of a score in [ -1, 1 ]) can't overflow,
+    // add ( ) asserts the visits stay within it.
+    // An update releases and a load acquires, a thread that sees the (virtual loss) visit of a
+    // new node also sees its untried moves.
+
+    class Statistics { // 8 bytes.
+
+        std::atomic<std::uint64_t> m_word { 0 };
+
+        [[ nodiscard ]] static std::uint64_t pack ( const float score_, const std::int32_t visits_ ) noexcept {
+            return ( ( std::uint64_t ) ( std::int64_t ) std::lround ( score_ * score_scale ) << 32 ) + ( std::uint32_t ) visits_;
+        }
+
+    public:
+
+        static constexpr float score_scale = 16.0f;
+        static constexpr std::int32_t max_visits = 1 << 27; // 2^31 / score_scale.
+
+        struct Snapshot {
+            float m_score;
+            std::int32_t m_visits;
+        };
+
+        Statistics ( ) noexcept { }
+
+        Statistics ( const Statistics & s_ ) noexcept : m_word ( s_.m_word.load ( std::memory_order_relaxed ) ) { }
+
+        Statistics & operator = ( const Statistics & s_ ) noexcept {
+            m_word.store ( s_.m_word.load ( std::memory_order_relaxed ), std::memory_order_relaxed );
+            return * this;
+        }
+
+        void add ( const float score_, const std::int32_t visits_ ) noexcept {
+            assert ( visits ( ) <= max_visits - visits_ ); // The score half would overflow.
+            m_word.fetch_add ( pack ( score_, visits_ ), std::memory_order_release );
+        }
+
+        void store ( const float score_, const std::int32_t visits_ ) noexcept {
+            m_word.store ( pack ( score_, visits_ ), std::memory_order_relaxed );
+        }
+
+        [[ nodiscard ]] Snapshot load ( ) const noexcept {
+            const std::uint64_t word = m_word.load ( std::memory_order_acquire );
+            return { ( float ) ( std::int32_t ) ( word >> 32 ) / score_scale, ( std::int32_t ) ( std::uint32_t ) word };
+        }
+
+        [[ nodiscard ]] std::int32_t visits ( ) const noexcept {
+            return ( std::int32_t ) ( std::uint32_t ) m_word.load ( std::memory_order_acquire );
+        }
+    };
+
+
+    // The pool of the moves is shared by all trees, and so by the threads of the parallel
+    // searches (of a shared tree, or of a tree each, see Mcts). Each thread keeps a cache of
+    // free moves of its own in front of it (see MovesCache), the lock of the pool is taken once
+    // per moves_cache_size allocations (or deallocations) only.
+
     template<typename State>
     struct NodeData { // 17 bytes.
 
         typedef State state_type;
-        typedef typename State::Moves Moves;
-        typedef typename State::Moves::value_type Move;
+        typedef typename State::CompactMoves Moves;
+        typedef typename State::CompactMove Move;
         typedef mp::MemoryPool<Moves, 65536> MovesPool;
         typedef llvm::OwningPtr<MovesPool> MovesPoolPtr;
 
         Moves * m_moves = nullptr;  // 8 bytes.
 
-        float m_score = 0.0f; // 4 bytes.
-        std::int32_t m_visits = 0; // 4 bytes.
+        Statistics m_statistics; // 8 bytes.
 
         Player m_player_just_moved = Player::Type::invalid; // 1 byte.
 
@@ -193,27 +263,32 @@ namespace mcts {
 
         NodeData ( const State & state_ ) noexcept {
             // std::cout << "nodedata constructed from state\n";
-            m_moves = new ( m_moves_pool->allocate ( ) ) Moves ( );
-            if ( not ( state_.moves ( m_moves ) ) ) {
-                m_moves_pool->deallocate ( m_moves );
-                m_moves = nullptr;
+            typename State::Moves moves;
+            if ( state_.moves ( & moves ) ) {
+                m_moves = allocateMoves ( );
+                for ( index_t i = 0; i < moves.size ( ); ++i ) {
+                    m_moves->push_back ( State::compact ( moves.at ( i ) ) );
+                }
             }
             m_player_just_moved = state_.playerJustMoved ( );
         }
 
+        NodeData ( const State & state_, const Move ) noexcept : NodeData ( state_ ) {
+            // The node and the arc of rt::Tree::addNode ( ) are constructed from the same arguments.
+        }
+
         NodeData ( const NodeData & nd_ ) noexcept {
 
             // std::cout << "nodedata copy constructed\n";
 
             if ( nd_.m_moves != nullptr ) {
 
-                m_moves = new ( m_moves_pool->allocate ( ) ) Moves ( );
+                m_moves = allocateMoves ( );
 
                 * m_moves = * nd_.m_moves;
             }
 
-            m_score = nd_.m_score;
-            m_visits = nd_.m_visits;
+            m_statistics = nd_.m_statistics;
             m_player_just_moved = nd_.m_player_just_moved;
         }
 
@@ -223,8 +298,7 @@ namespace mcts {
 
             std::swap ( m_moves, nd_.m_moves );
 
-            m_score = std::move ( nd_.m_score );
-            m_visits = std::move ( nd_.m_visits );
+            m_statistics = nd_.m_statistics;
             m_player_just_moved = std::move ( nd_.m_player_just_moved );
         }
 
@@ -234,7 +308,7 @@ namespace mcts {
 
                 // std::cout << "moves deallocated\n";
 
-                m_moves_pool->deallocate ( m_moves );
+                deallocateMoves ( m_moves );
             }
         }
 
@@ -244,7 +318,7 @@ namespace mcts {
 
                 const Move move = m_moves->front ( );
 
-                m_moves_pool->deallocate ( m_moves );
+                deallocateMoves ( m_moves );
 
                 m_moves = nullptr;
 
@@ -254,47 +328,111 @@ namespace mcts {
             return m_moves->draw ( );
         }
 
-        [[ nodiscard ]] NodeData & operator += ( const NodeData & rhs_ ) noexcept {
+        void removeUntriedMove ( const Move move_ ) noexcept {
+            if ( m_moves != nullptr ) {
+                m_moves->remove ( move_ );
+                if ( m_moves->empty ( ) ) {
+                    deallocateMoves ( m_moves );
+                    m_moves = nullptr;
+                }
+            }
+        }
+
+        [[ maybe_unused ]] NodeData & operator += ( const NodeData & rhs_ ) noexcept {
 
-            m_score += rhs_.m_score;
-            m_visits += rhs_.m_visits;
+            const Statistics::Snapshot statistics = rhs_.m_statistics.load ( );
+            m_statistics.add ( statistics.m_score, statistics.m_visits );
 
             return * this;
         }
 
 
-        [[ nodiscard ]] NodeData & operator = ( const NodeData & nd_ ) noexcept {
+        [[ maybe_unused ]] NodeData & operator = ( const NodeData & nd_ ) noexcept {
 
             // std::cout << "nodedata copy assigned\n";
 
             if ( nd_.m_moves != nullptr ) {
 
-                m_moves = new ( m_moves_pool->allocate ( ) ) Moves ( );
+                m_moves = allocateMoves ( );
 
                 * m_moves = * nd_.m_moves;
             }
 
-            m_score = nd_.m_score;
-            m_visits = nd_.m_visits;
+            m_statistics = nd_.m_statistics;
             m_player_just_moved = nd_.m_player_just_moved;
 
             return * this;
         }
 
-        [[ nodiscard ]] NodeData & operator = ( NodeData && nd_ ) noexcept {
+        [[ maybe_unused ]] NodeData & operator = ( NodeData && nd_ ) noexcept {
 
             // std::cout << "nodedata move assigned\n";
 
             std::swap ( m_moves, nd_.m_moves );
 
-            m_score = std::move ( nd_.m_score );
-            m_visits = std::move ( nd_.m_visits );
+            m_statistics = nd_.m_statistics;
             m_player_just_moved = std::move ( nd_.m_player_just_moved );
 
             return * this;
         }
 
         static MovesPoolPtr m_moves_pool;
+        static SRWLock<true> m_moves_pool_lock;
+
+        static constexpr index_t moves_cache_size = 64;
+
+        // The free moves of a thread, refilled from (and spilled to) the pool moves_cache_size at
+        // a time. The blocks stay with the pool, moves can be freed by another thread than the
+        // one that allocated them, the cache of a thread is returned to the pool on its exit.
+
+        struct MovesCache {
+
+            boost::container::static_vector<Moves*, 2 * moves_cache_size> m_free;
+
+            ~MovesCache ( ) noexcept {
+                spill ( m_free.size ( ) );
+            }
+
+            void refill ( ) noexcept {
+                m_moves_pool_lock.lock ( );
+                while ( m_free.size ( ) < moves_cache_size ) {
+                    m_free.push_back ( m_moves_pool->allocate ( ) );
+                }
+                m_moves_pool_lock.unlock ( );
+            }
+
+            void spill ( index_t n_ ) noexcept {
+                m_moves_pool_lock.lock ( );
+                for ( ; n_; --n_ ) {
+                    m_moves_pool->deallocate ( m_free.back ( ) );
+                    m_free.pop_back ( );
+                }
+                m_moves_pool_lock.unlock ( );
+            }
+        };
+
+        [[ nodiscard ]] static MovesCache & movesCache ( ) noexcept {
+            thread_local MovesCache cache;
+            return cache;
+        }
+
+        [[ nodiscard ]] static Moves * allocateMoves ( ) noexcept {
+            MovesCache & cache = movesCache ( );
+            if ( cache.m_free.empty ( ) ) {
+                cache.refill ( );
+            }
+            Moves * const moves = new ( cache.m_free.back ( ) ) Moves ( );
+            cache.m_free.pop_back ( );
+            return moves;
+        }
+
+        static void deallocateMoves ( Moves * moves_ ) noexcept {
+            MovesCache & cache = movesCache ( );
+            if ( cache.m_free.size ( ) == cache.m_free.capacity ( ) ) {
+                cache.spill ( moves_cache_size );
+            }
+            cache.m_free.push_back ( moves_ );
+        }
 
     private:
 
@@ -318,7 +456,9 @@ namespace mcts {
                 ar_ ( tmp );
             }
 
-            ar_ ( m_score, m_visits, m_player_just_moved );
+            const Statistics::Snapshot statistics = m_statistics.load ( );
+
+            ar_ ( statistics.m_score, statistics.m_visits, m_player_just_moved );
         }
 
         template < class Archive >
@@ -330,54 +470,82 @@ namespace mcts {
 
             if ( tmp == 2 ) {
 
-                m_moves = new ( m_moves_pool->allocate ( ) ) Moves ( );
+                m_moves = allocateMoves ( );
                 m_moves->serialize ( ar_ );
             }
 
-            ar_ ( m_score, m_visits, m_player_just_moved );
+            float score = 0.0f;
+            std::int32_t visits = 0;
+
+            ar_ ( score, visits, m_player_just_moved );
+
+            m_statistics.store ( score, visits );
         }
     };
 
     template < typename State >
     typename NodeData < State >::MovesPoolPtr NodeData < State >::m_moves_pool ( new MovesPool ( ) );
+    template < typename State >
+    SRWLock < true > NodeData < State >::m_moves_pool_lock;
 
 
-    template <typename State>
-    using Tree = rt::Tree < ArcData < State >, NodeData < State > >;
+    template <typename State, bool Locking = false>
+    using Tree = rt::Tree < ArcData < State >, NodeData < State >, Locking >;
 
-    template < typename State >
-    using Node = typename Tree < State >::Node;
+    template < typename State, bool Locking = false >
+    using Node = typename Tree < State, Locking >::Node;
 
-    template < typename State >
-    using Arc = typename Tree < State >::Arc;
+    template < typename State, bool Locking = false >
+    using Arc = typename Tree < State, Locking >::Arc;
 
 
-    template < typename State >
+    // With Canonical, a position and its left-right reflection share a node (they are keyed by
+    // State::canonical ( )). The moves of a node and those of its out-arcs are stored in the
+    // orientation with the lower hash, moves are reflected to and from the orientation of the
+    // state walking the tree as required. Policy picks the moves of the play-outs (see the
+    // State's playout ( )), a learning Policy also learns from the tree moves (see Playout.hpp).
+    // With Locking, the tree is the locking rt::Tree and compute ( ) runs a tree parallel search,
+    // the threads share the tree (see search ( )). The play-outs of a leaf of the agent's search
+    // are backed up in one pass, they run on a PlayoutPool if set (see setPlayouts ( )).
+
+    template < typename State, bool Canonical = false, typename Policy = typename State::PlayoutPolicy, bool Locking = false >
     class Mcts {
 
     public:
 
-        typedef Tree < State > Tree;
+        typedef mcts::Tree < State, Locking > Tree;
 
         typedef typename Tree::Arc Arc;
         typedef typename Tree::Node Node;
 
-        typedef ArcData < State > ArcData;
-        typedef NodeData < State > NodeData;
+        typedef mcts::ArcData < State > ArcData;
+        typedef mcts::NodeData < State > NodeData;
 
         typedef typename Tree::InIt InIt;
         typedef typename Tree::OutIt OutIt;
 
         typedef typename State::Move Move;
         typedef typename State::Moves Moves;
+        typedef typename State::CompactMoves CompactMoves; // The untried moves of a node, the moves of the arcs are compact too.
+        typedef typename State::UndoRecord UndoRecord;
 
         typedef rt::Link < Tree > Link;
         typedef rt::Path < Tree > Path;
 
-        typedef std::unordered_map < ZobristHash, Node > TranspositionTable;
+        typedef rt::TranspositionTable < Tree, ZobristHash, Node, Locking > TranspositionTable; // Lock-free if Locking.
         typedef std::vector < ZobristHash > InverseTranspositionTable;
         typedef llvm::OwningPtr < TranspositionTable > TranspositionTablePtr;
 
+        typedef mcts::PlayoutPool < State, Policy > PlayoutPool;
+        typedef llvm::OwningPtr < PlayoutPool > PlayoutPoolPtr;
+
+        static constexpr index_t default_no_playouts = 10; // Per leaf, of the agent's search.
+
+        typedef std::chrono::steady_clock Clock;
+
+        static constexpr index_t clock_interval = 64; // The iterations between two looks at the clock, of a timed search.
+        static constexpr index_t max_ponder_playouts = 1 << 24; // Of one turn of the human.
+
         // The data.
 
         Tree m_tree;
@@ -394,6 +562,29 @@ namespace mcts {
         Path m_path;
         index_t m_path_size;
 
+        bool m_is_reflected = false; // The state at the back of m_path is reflected w.r.t. its node.
+
+        index_t m_no_playouts = default_no_playouts;
+        PlayoutPoolPtr m_playout_pool; // Leaf parallelization, none is the play-outs on the searching thread.
+
+        index_t m_no_iterations = 0; // Done by the last compute ( ), of all threads.
+        std::atomic < index_t > m_progress { 0 }; // The iterations of the search in progress, by clock_interval, see AsyncSearch::poll ( ).
+
+        std::atomic < bool > m_stop { false }; // See stop ( ).
+        std::thread m_ponder_thread;
+
+        // The play-outs per leaf of the agent's search, and the threads doing them (1 is the
+        // searching thread only, 0 is one per processor). A tree parallel search does the
+        // play-outs on its own threads.
+
+        void setPlayouts ( const index_t no_playouts_, index_t no_threads_ = 1 ) {
+            m_no_playouts = std::max ( 1, no_playouts_ );
+            if ( no_threads_ < 1 ) {
+                no_threads_ = std::max ( 1, ( index_t ) getNumberOfProcessors ( ) );
+            }
+            m_playout_pool.reset ( Locking or 1 == no_threads_ ? nullptr : new PlayoutPool ( no_threads_ ) );
+        }
+
         // Init.
 
         void initialize ( const State & state_ ) noexcept {
@@ -407,10 +598,12 @@ namespace mcts {
 
             m_tree [ m_tree.root_arc  ] =  ArcData ( state_ );
             m_tree [ m_tree.root_node ] = NodeData ( state_ );
+            m_is_reflected = isReflected ( state_ );
+            reflectMoves ( m_tree.root_node, state_ );
 
             // Add root_node to transposition_table.
 
-            m_transposition_table->emplace ( state_.zobrist ( ) [ 0 ], m_tree.root_node );
+            m_transposition_table->emplace ( key ( state_ ), m_tree.root_node );
 
             // Has been initialized.
 
@@ -421,34 +614,78 @@ namespace mcts {
         }
 
 
-        [[ nodiscard ]] Link addArc ( const Node parent_, const Node child_, const State & state_ ) noexcept {
-            return m_tree.addArc ( parent_, child_, state_ );
+        // The move of the arc is in the orientation of the parent, the arc is complete when it's linked.
+
+        [[ nodiscard ]] Link addArc ( const Node parent_, const Node child_, const State & state_, const Move & move_ ) noexcept {
+            return m_tree.addArc ( parent_, child_, state_, State::compact ( move_ ) );
         }
 
-        [[ nodiscard ]] Link addNode ( const Node parent_, const State & state_ ) noexcept {
-            const Link child = m_tree.addNode ( parent_, state_ );
-            m_transposition_table->emplace ( state_.zobrist ( ) [ 0 ], child.target );
+        [[ nodiscard ]] Link addNode ( const Node parent_, const State & state_, const Move & move_ ) noexcept {
+            const Link child = m_tree.addNode ( parent_, state_, State::compact ( move_ ) );
+            reflectMoves ( child.target, state_ );
+            m_transposition_table->emplace ( key ( state_ ), child.target );
             return child;
         }
 
 
+        // Canonical keys and orientation.
+
+        [[ nodiscard ]] static ZobristHash key ( const State & state_ ) noexcept {
+            if constexpr ( Canonical ) {
+                return state_.canonical ( );
+            }
+            else {
+                return state_.zobrist ( );
+            }
+        }
+
+        [[ nodiscard ]] static bool isReflected ( const State & state_ ) noexcept {
+            if constexpr ( Canonical ) {
+                return state_.isReflected ( );
+            }
+            else {
+                return false;
+            }
+        }
+
+        // Reflection is its own inverse, the same call maps a move from the node's orientation
+        // to that of the state and back.
+
+        [[ nodiscard ]] static Move orient ( const bool is_reflected_, const Move & move_ ) noexcept {
+            if constexpr ( Canonical ) {
+                return is_reflected_ ? State::reflect ( move_ ) : move_;
+            }
+            else {
+                return move_;
+            }
+        }
+
+        void reflectMoves ( const Node node_, const State & state_ ) noexcept {
+            CompactMoves * const moves = m_tree [ node_ ].m_moves;
+            if ( moves != nullptr and isReflected ( state_ ) ) {
+                for ( index_t i = 0; i < moves->size ( ); ++i ) {
+                    ( * moves ) [ i ] = State::compact ( orient ( true, State::expand ( moves->at ( i ) ) ) );
+                }
+            }
+        }
+
+
         void printMoves ( const Node n_ ) const noexcept {
             std::cout << "moves of " << ( int ) n_ << ": ";
             for ( OutIt a ( m_tree, n_ ); a != OutIt::end ( ); ++a ) {
-                std::cout << "[" << ( int ) a.get ( ) << ", " << ( int ) m_tree [ a ].m_move.m_loc << "]";
+                std::cout << "[" << ( int ) a.get ( ) << ", " << ( int ) m_tree [ a ].m_move.v << "]";
             }
             putchar ( '\n' );
         }
 
 
         [[ nodiscard ]] Move getMove ( const Arc arc_ ) const noexcept {
-            return m_tree [ arc_ ].m_move;
+            return State::expand ( m_tree [ arc_ ].m_move );
         }
 
 
         [[ nodiscard ]] Node getNode ( const ZobristHash zobrist_ ) const noexcept {
-            const auto it = m_transposition_table->find ( zobrist_ );
-            return it == m_transposition_table->cend ( ) ? Tree::invalid_node : it->second;
+            return m_transposition_table->get ( zobrist_ );
         }
 
 
@@ -470,7 +707,7 @@ namespace mcts {
 
 
         [[ nodiscard ]] Move getUntriedMove ( const Node node_ ) noexcept {
-            return m_tree [ node_ ].getUntriedMove ( );
+            return State::expand ( m_tree [ node_ ].getUntriedMove ( ) );
         }
 
 
@@ -502,10 +739,11 @@ namespace mcts {
 
 
         [[ nodiscard ]] float getUCTFromNode ( const Node parent_, const Node child_ ) const noexcept {
+            const Statistics::Snapshot child = m_tree [ child_ ].m_statistics.load ( );
             //                              Exploitation                                                             Exploration
             // Exploitation is the task to select the move that leads to the best results so far.
             // Exploration deals with less promising moves that still have to be examined, due to the uncertainty of the evaluation.
-            return ( float ) m_tree [ child_ ].m_score / ( float ) m_tree [ child_ ].m_visits + sqrtf ( 4.0f * logf ( ( float ) ( m_tree [ parent_ ].m_visits + 1 ) ) / ( float ) m_tree [ child_ ].m_visits );
+            return child.m_score / ( float ) child.m_visits + sqrtf ( 4.0f * logf ( ( float ) ( m_tree [ parent_ ].m_statistics.visits ( ) + 1 ) ) / ( float ) child.m_visits );
         }
 
 
@@ -540,19 +778,169 @@ namespace mcts {
         }
 
 
-        [[ nodiscard ]] Link addChild ( const Node parent_, const State & state_ ) noexcept {
-            // State is updated to reflect move.
-            const Node child = getNode ( state_.zobrist ( ) [ 0 ] );
-            return child == Tree::invalid_node ? addNode ( parent_, state_ ) : addArc ( parent_, child, state_ );
+        [[ nodiscard ]] Link addChild ( const Node parent_, const State & state_, const Move & move_ ) noexcept {
+            // State is updated to reflect move, move_ is in the orientation of the parent.
+            if constexpr ( Locking ) {
+                // The look-up and the insertion of a child are one step, the thread that claims the
+                // key adds the node, the others add an arc to it.
+                Link link;
+                const auto [ child, is_added ] = m_transposition_table->insert_or_get ( key ( state_ ), [ & ] ( ) {
+                    link = m_tree.addNode ( parent_, state_, State::compact ( move_ ) );
+                    reflectMoves ( link.target, state_ );
+                    return link.target;
+                } );
+                return is_added ? link : addArc ( parent_, child, state_, move_ );
+            }
+            else {
+                const Node child = getNode ( key ( state_ ) );
+                return child == Tree::invalid_node ? addNode ( parent_, state_, move_ ) : addArc ( parent_, child, state_, move_ );
+            }
         }
 
 
-        void updateData ( Link && link_, const State & state_ ) noexcept {
-            const float result = state_.result ( m_tree [ link_.target ].m_player_just_moved );
-            // ++m_tree [ link_.arc ].m_visits;
+        [[ nodiscard ]] Tally playouts ( const State & state_, const Player player_ ) noexcept {
+            // The play-outs of a leaf, one for the human, as many as set for the agent.
+            const index_t no_playouts = player_ == Player::Type::human ? 1 : m_no_playouts;
+            return m_playout_pool.get ( ) == nullptr ? PlayoutPool::playouts ( state_, no_playouts ) : m_playout_pool->run ( state_, no_playouts );
+        }
+
+
+        void updateData ( Link && link_, const Tally & tally_ ) noexcept {
+            const float result = tally_.template score < State > ( m_tree [ link_.target ].m_player_just_moved );
+            // m_tree [ link_.arc ].m_visits += tally_.size ( );
             // m_tree [ link_.arc ].m_score += result;
-            ++m_tree [ link_.target ].m_visits;
-            m_tree [ link_.target ].m_score += result;
+            m_tree [ link_.target ].m_statistics.add ( result, tally_.size ( ) );
+        }
+
+
+        void updateMoveStatistics ( const std::vector < std::pair < Move, UndoRecord > > & undo_, const Player player_, const Tally & tally_ ) const noexcept {
+            // A learning Policy also learns from the moves of the tree part of the iteration (the
+            // play-out credits its own), in the players' orientation, player_ made the first move.
+            if constexpr ( Policy::is_learning ) {
+                for ( index_t i = 0; i < 3; ++i ) {
+                    for ( std::int32_t n = 0; n < tally_.m_wins [ i ]; ++n ) {
+                        Player player = player_;
+                        for ( const auto & move : undo_ ) {
+                            Policy::template update < typename State::BitState > ( player, move.first, Tally::winner ( i ) );
+                            player.next ( );
+                        }
+                    }
+                }
+            }
+        }
+
+
+        // Tree parallelization (Locking). A node is locked for the access to its out-arcs and its
+        // untried moves, its statistics are atomic (see Statistics). A visit is counted on the way
+        // down, with a loss (a virtual loss, taken back in the back-up), the other threads see the
+        // node as visited and lost, and spread out over the tree.
+
+        void addVirtualLoss ( const Node node_ ) noexcept {
+            m_tree [ node_ ].m_statistics.add ( -1.0f, 1 );
+        }
+
+        void backUp ( const Node node_, const Tally & tally_ ) noexcept {
+            NodeData & data = m_tree [ node_ ];
+            data.m_statistics.add ( tally_.template score < State > ( data.m_player_just_moved ) + 1.0f, tally_.size ( ) - 1 ); // The visit and the loss of the virtual loss.
+        }
+
+
+        [[ nodiscard ]] Link selectChildUCTConcurrent ( const Node parent_ ) noexcept {
+            // As selectChildUCT ( ), the children that are still being added (no visits yet) are
+            // skipped, the link is invalid if none remain.
+            boost::container::static_vector < Link, State::max_no_moves > best_children;
+            float best_UCT_score = 0.0f;
+            m_tree.lockRead ( parent_ );
+            const float exploration = 4.0f * logf ( ( float ) ( m_tree [ parent_ ].m_statistics.visits ( ) + 1 ) );
+            for ( OutIt a ( m_tree, parent_ ); a != OutIt::end ( ); ++a ) {
+                const Link child = m_tree.link ( a );
+                const Statistics::Snapshot statistics = m_tree [ child.target ].m_statistics.load ( );
+                if ( not ( statistics.m_visits ) ) {
+                    continue;
+                }
+                const float UCT_score = statistics.m_score / ( float ) statistics.m_visits + sqrtf ( exploration / ( float ) statistics.m_visits );
+                if ( best_children.empty ( ) or UCT_score > best_UCT_score ) {
+                    best_children.resize ( 1 );
+                    best_children.back ( ) = child;
+                    best_UCT_score = UCT_score;
+                }
+                else if ( UCT_score == best_UCT_score ) {
+                    best_children.push_back ( child );
+                }
+            }
+            m_tree.unlockRead ( parent_ );
+            if ( best_children.empty ( ) ) {
+                return Link ( Tree::invalid_arc, Tree::invalid_node );
+            }
+            // Ties are broken by fair coin flips.
+            return best_children.size ( ) == 1 ? best_children.back ( ) : best_children [ std::uniform_int_distribution < ptrdiff_t > ( 0, best_children.size ( ) - 1 ) ( g_rng ) ];
+        }
+
+
+        [[ nodiscard ]] index_t search ( const State & state_, const Player player_, std::atomic < index_t > & iterations_, std::atomic < index_t > & playouts_, const Clock::time_point deadline_ ) noexcept {
+            // One thread of the tree parallel search, with a state, a path and undo records of its own,
+            // returns the number of iterations it did. The thread that finds the deadline_ passed, the
+            // play-outs_ (the budget left, shared by the threads) used up (or a stop ( )) stops the others.
+            State state ( state_ );
+            Path path ( m_path );
+            std::vector < std::pair < Move, UndoRecord > > undo;
+            undo.reserve ( 128 );
+            index_t no_iterations = 0;
+            while ( iterations_.fetch_sub ( 1, std::memory_order_relaxed ) > 0 ) {
+                for ( const Link & link : path ) {
+                    addVirtualLoss ( link.target );
+                }
+                Node node = m_path.back ( ).target; // The node of state_, the root of a new tree.
+                bool is_reflected = m_is_reflected;
+                // Select a path through the tree to a node with untried moves and expand it, or to a
+                // leaf node (or to a node of which the children are still being added).
+                while ( true ) {
+                    m_tree.lock ( node );
+                    if ( hasUntriedMoves ( node ) ) {
+                        const Move move = getUntriedMove ( node );
+                        m_tree.unlock ( node );
+                        undo.emplace_back ( orient ( is_reflected, move ), UndoRecord ( ) );
+                        state.make_hash_winner ( undo.back ( ).first, undo.back ( ).second ); // State update.
+                        const Link child = addChild ( node, state, move );
+                        addVirtualLoss ( child.target );
+                        path.push ( child );
+                        break;
+                    }
+                    m_tree.unlock ( node );
+                    const Link child = selectChildUCTConcurrent ( node );
+                    if ( child.arc == Tree::invalid_arc ) {
+                        break;
+                    }
+                    addVirtualLoss ( child.target );
+                    undo.emplace_back ( orient ( is_reflected, State::expand ( m_tree [ child.arc ].m_move ) ), UndoRecord ( ) );
+                    state.make_hash ( undo.back ( ).first, undo.back ( ).second );
+                    is_reflected = isReflected ( state );
+                    path.push ( child );
+                    node = child.target;
+                }
+                const Tally tally = playouts ( state, player_ );
+                for ( const Link & link : path ) {
+                    backUp ( link.target, tally );
+                }
+                if ( playouts_.fetch_sub ( tally.size ( ), std::memory_order_relaxed ) <= tally.size ( ) ) {
+                    iterations_.store ( 0, std::memory_order_relaxed );
+                }
+                updateMoveStatistics ( undo, player_, tally );
+                path.resize ( m_path_size );
+                for ( ; undo.size ( ); undo.pop_back ( ) ) {
+                    state.unmake ( undo.back ( ).first, undo.back ( ).second );
+                }
+                if ( not ( ++no_iterations % clock_interval ) ) {
+                    m_progress.fetch_add ( clock_interval, std::memory_order_relaxed );
+                    if ( Clock::now ( ) >= deadline_ ) {
+                        iterations_.store ( 0, std::memory_order_relaxed );
+                    }
+                }
+                if ( m_stop.load ( std::memory_order_relaxed ) ) {
+                    iterations_.store ( 0, std::memory_order_relaxed );
+                }
+            }
+            return no_iterations;
         }
 
 
@@ -560,14 +948,15 @@ namespace mcts {
             // Find the node (the most robust) with the most visits.
             std::int32_t best_child_visits = INT_MIN;
             Move best_child_move = State::Move::none;
+            const Node parent = m_path.back ( ).target;
             m_path.push ( Tree::invalid_arc, Tree::invalid_node );
             ++m_path_size;
-            for ( OutIt a ( m_tree, m_tree.root_node ); a != OutIt::end ( ); ++a ) {
+            for ( OutIt a ( m_tree, parent ); a != OutIt::end ( ); ++a ) {
                 const Link child ( m_tree.link ( a ) );
-                const std::int32_t child_visits ( m_tree [ child.target ].m_visits );
+                const std::int32_t child_visits ( m_tree [ child.target ].m_statistics.visits ( ) );
                 if ( child_visits > best_child_visits ) {
                     best_child_visits = child_visits;
-                    best_child_move = m_tree [ child.arc ].m_move;
+                    best_child_move = orient ( m_is_reflected, State::expand ( m_tree [ child.arc ].m_move ) );
                     m_path.back ( ) = child;
                 }
             }
@@ -577,38 +966,165 @@ namespace mcts {
 
         void connectStatesPath ( const State & state_ ) noexcept {
             // Adding the move of the opponent to the path (and possibly to the tree).
-            const Node parent = m_path.back ( ).target; Node child = getNode ( state_.zobrist ( ) [ 0 ] );
+            const Node parent = m_path.back ( ).target; Node child = getNode ( key ( state_ ) );
             if ( child == Tree::invalid_node ) {
-                child = addNode ( parent, state_ ).target;
+                child = addNode ( parent, state_, orient ( m_is_reflected, state_.lastMove ( ) ) ).target;
             }
+            m_is_reflected = isReflected ( state_ );
             m_path.push ( m_tree.link ( parent, child ) );
             ++m_path_size;
         }
 
 
-        [[ nodiscard ]] Move compute ( const State & state_, index_t max_iterations_ = 100'000 ) noexcept {
-            // constexpr std::int32_t threshold = 5;
+        [[ nodiscard ]] Move compute ( const State & state_, index_t max_iterations_ = 100'000, index_t no_threads_ = 0 ) noexcept {
+            // The iterations are shared by no_threads_ threads (Locking only), 0 threads is one per processor.
+            if constexpr ( Policy::is_learning ) {
+                Policy::template age < typename State::BitState > ( );
+            }
+            return iterate ( state_, max_iterations_, no_threads_ );
+        }
+
+
+        // As compute ( ), an anytime search, until the deadline_ (or for the budget_ from now), the
+        // clock is looked at every clock_interval iterations. The best move so far is returned,
+        // after at least one iteration. The iterations done are in m_no_iterations.
+
+        [[ nodiscard ]] Move compute ( const State & state_, const Clock::time_point deadline_, const index_t no_threads_ = 0 ) noexcept {
+            if constexpr ( Policy::is_learning ) {
+                Policy::template age < typename State::BitState > ( );
+            }
+            return iterate ( state_, INT_MAX, no_threads_, deadline_ );
+        }
+
+        [[ nodiscard ]] Move compute ( const State & state_, const Clock::duration budget_, const index_t no_threads_ = 0 ) noexcept {
+            return compute ( state_, Clock::now ( ) + budget_, no_threads_ );
+        }
+
+
+        // Ends the search in progress (or the next one, stop ( ) is safe from any thread), after at
+        // least one iteration, compute ( ) returns the best move so far.
+
+        void stop ( ) noexcept {
+            m_stop.store ( true, std::memory_order_relaxed );
+        }
+
+
+        // Pondering, the search goes on (on a thread of its own) during the human's turn, from
+        // state_ (the position after the agent's move, at the back of m_path, or the root), the
+        // iterations spread over the replies as the UCT of the human has it. The next compute ( ),
+        // after stopPondering ( ), connects the human's move to the path (see connectStatesPath ( ))
+        // and continues with its subtree. The tree is not touched by anything else until then.
+        // The pondering stops after max_ponder_playouts (as any search, before the root would
+        // exceed Statistics::max_visits, see grow ( )).
+
+        void startPondering ( const State & state_ ) {
+            stopPondering ( );
+            m_stop.store ( false, std::memory_order_relaxed ); // A stop ( ) that came after the last search.
+            if ( m_not_initialized ) {
+                initialize ( state_ );
+            }
+            m_ponder_thread = std::thread ( [ this, state_ ] ( ) { grow ( state_, INT_MAX, 1, Clock::time_point::max ( ), max_ponder_playouts ); } );
+        }
+
+        void stopPondering ( ) noexcept {
+            if ( m_ponder_thread.joinable ( ) ) {
+                stop ( );
+                m_ponder_thread.join ( );
+                m_stop.store ( false, std::memory_order_relaxed ); // The pondering can have ended before the stop ( ).
+            }
+        }
+
+        ~Mcts ( ) noexcept {
+            stopPondering ( );
+        }
+
+
+        [[ nodiscard ]] Move iterate ( const State & state_, const index_t max_iterations_, index_t no_threads_, const Clock::time_point deadline_ = Clock::time_point::max ( ) ) noexcept {
+            // As compute ( ), without ageing a learning Policy.
             if ( m_not_initialized ) {
                 initialize ( state_ );
             }
             else {
                 connectStatesPath ( state_ );
             }
+            grow ( state_, max_iterations_, no_threads_, deadline_ );
+            const Move move = getBestMove ( );
+            if constexpr ( Canonical ) {
+                // The orientation of the position after the move, now at the back of m_path, for
+                // connectStatesPath ( ) and pondering.
+                if ( move != State::Move::none ) {
+                    State state ( state_ );
+                    state.move_hash ( move );
+                    m_is_reflected = isReflected ( state );
+                }
+            }
+            return move;
+        }
+
+
+        [[ nodiscard ]] index_t maxPlayouts ( const index_t max_playouts_, const index_t no_threads_ ) noexcept {
+            // The play-outs a search can do, see grow ( ).
+            return std::min ( max_playouts_, Statistics::max_visits - no_threads_ * ( m_no_playouts + 1 ) - m_tree [ m_tree.root_node ].m_statistics.visits ( ) );
+        }
+
+
+        void grow ( const State & state_, const index_t max_iterations_, index_t no_threads_, const Clock::time_point deadline_, const index_t max_playouts_ = INT_MAX ) noexcept {
+            // The iterations from the back of m_path (state_), until max_iterations_, the deadline_,
+            // max_playouts_ or a stop ( ). The play-outs are counted by the tallies (the human's leaves
+            // have one). The root (of the game, it has the most visits) takes as many visits as there
+            // are play-outs, the play-outs are capped such that it stays within Statistics::max_visits,
+            // with room for a leaf and a virtual loss in flight on each thread.
+            // constexpr std::int32_t threshold = 5;
             const Player player = state_.playerToMove ( );
             if ( player == Player::Type::agent ) {
                 // m_path.print ( );
             }
+            m_progress.store ( 0, std::memory_order_relaxed );
+            if constexpr ( Locking ) {
+                if ( no_threads_ < 1 ) {
+                    no_threads_ = std::max ( 1, ( index_t ) getNumberOfProcessors ( ) );
+                }
+                // The tables the last search chained (see rt::TranspositionTable) are folded into one.
+                m_transposition_table->reserve ( 2 * m_transposition_table->size ( ) );
+                std::atomic < index_t > iterations { max_iterations_ }, no_iterations { 0 }, playouts { maxPlayouts ( max_playouts_, no_threads_ ) };
+                if ( playouts <= 0 ) {
+                    iterations = 0;
+                }
+                auto work = [ & ] ( ) {
+                    no_iterations.fetch_add ( search ( state_, player, iterations, playouts, deadline_ ), std::memory_order_relaxed );
+                };
+                std::vector < std::thread > threads;
+                for ( index_t t = 1; t < no_threads_; ++t ) {
+                    threads.emplace_back ( work );
+                }
+                work ( );
+                for ( std::thread & thread : threads ) {
+                    thread.join ( );
+                }
+                m_no_iterations = no_iterations;
+                m_progress.store ( m_no_iterations, std::memory_order_relaxed );
+                m_stop.store ( false, std::memory_order_relaxed );
+                return;
+            }
             // max_iterations_ -= m_tree.nodeNum ( );
-            while ( max_iterations_-- > 0 ) {
-                Node node = m_tree.root_node;
-                State state ( state_ );
+            // One state is walked down the tree and back up again (unmake), per iteration.
+            State state ( state_ );
+            std::vector < std::pair < Move, UndoRecord > > undo;
+            undo.reserve ( 128 );
+            const index_t max_playouts = maxPlayouts ( max_playouts_, 1 );
+            index_t no_iterations = 0, no_playouts = 0;
+            while ( no_iterations < max_iterations_ and no_playouts < max_playouts ) {
+                Node node = m_path.back ( ).target; // The node of state_, the root of a new tree.
+                bool is_reflected = m_is_reflected;
                 // Select a path through the tree to a leaf node.
                 while ( hasNoUntriedMoves ( node ) and hasChildren ( node ) ) {
                     // UCT is only applied in nodes of which the visit count
                     // is higher than a certain threshold T
                     // Link child = player == Player::Type::agent and m_tree [ node ].m_visits < threshold ? selectChildRandom ( node ) :
                     Link child = selectChildUCT ( node );
-                    state.move_hash ( m_tree [ child.arc ].m_move );
+                    undo.emplace_back ( orient ( is_reflected, State::expand ( m_tree [ child.arc ].m_move ) ), UndoRecord ( ) );
+                    state.make_hash ( undo.back ( ).first, undo.back ( ).second );
+                    is_reflected = isReflected ( state );
                     m_path.push ( child );
                     node = child.target;
                 }
@@ -636,36 +1152,40 @@ namespace mcts {
 
                 if ( hasUntriedMoves ( node ) ) {
                     //if ( player == Player::Type::agent and m_tree [ node ].m_visits < threshold )
-                    state.move_hash_winner ( getUntriedMove ( node ) ); // State update.
-                    m_path.push ( addChild ( node, state ) );
+                    const Move move = getUntriedMove ( node );
+                    undo.emplace_back ( orient ( is_reflected, move ), UndoRecord ( ) );
+                    state.make_hash_winner ( undo.back ( ).first, undo.back ( ).second ); // State update.
+                    m_path.push ( addChild ( node, state, move ) );
                 }
 
                 // The player in back of path is player ( the player to move ).We now play
                 // randomly until the game ends.
 
-                if ( player == Player::Type::human ) {
-                    state.simulate ( );
-                    for ( Link link : m_path ) {
-                        // We have now reached a final state. Backpropagate the result up the
-                        // tree to the root node.
-                        updateData ( std::move ( link ), state );
-                    }
+                const Tally tally = playouts ( state, player );
+                no_playouts += tally.size ( );
+                for ( Link link : m_path ) {
+                    // We have now reached the final states. Backpropagate the results up the
+                    // tree to the root node, in one pass.
+                    updateData ( std::move ( link ), tally );
                 }
-
-                else {
-                    for ( index_t i = 0; i < 10; ++i ) {
-                        State sim_state ( state );
-                        sim_state.simulate ( );
-                        // We have now reached a final state. Backpropagate the result up the
-                        // tree to the root node.
-                        for ( Link link : m_path ) {
-                            updateData ( std::move ( link ), sim_state );
-                        }
+                updateMoveStatistics ( undo, player, tally );
+                m_path.resize ( m_path_size );
+                for ( ; undo.size ( ); undo.pop_back ( ) ) {
+                    state.unmake ( undo.back ( ).first, undo.back ( ).second );
+                }
+                if ( not ( ++no_iterations % clock_interval ) ) {
+                    m_progress.store ( no_iterations, std::memory_order_relaxed );
+                    if ( Clock::now ( ) >= deadline_ ) {
+                        break;
                     }
                 }
-                m_path.resize ( m_path_size );
+                if ( m_stop.load ( std::memory_order_relaxed ) ) {
+                    break;
+                }
             }
-            return getBestMove ( );
+            m_no_iterations = no_iterations;
+            m_progress.store ( m_no_iterations, std::memory_order_relaxed );
+            m_stop.store ( false, std::memory_order_relaxed );
         }
 
 
@@ -678,7 +1198,7 @@ namespace mcts {
 
             // Prune Tree.
 
-            const Node old_node = getNode ( state_.zobrist ( ) [ 0 ] );
+            const Node old_node = getNode ( key ( state_ ) );
 
             Visited visited ( m_tree.nodeNum ( ), Tree::invalid_node );
 
@@ -718,27 +1238,7 @@ namespace mcts {
 
             // Purge TransitionTable.
 
-            auto it = m_transposition_table->begin ( );
-            const auto it_cend = m_transposition_table->cend ( );
-
-            while ( it != it_cend ) {
-
-                const auto tmp_it = it;
-
-                ++it;
-
-                const Node new_node = visited [ tmp_it->second ];
-
-                if ( new_node == Tree::invalid_node ) {
-
-                    m_transposition_table->erase ( tmp_it );
-                }
-
-                else {
-
-                    tmp_it->second = new_node;
-                }
-            }
+            m_transposition_table->remap ( [ & visited ] ( const Node old_node_ ) { return visited [ old_node_ ]; } );
 
             // Transfer TranspositionTable.
 
@@ -752,12 +1252,60 @@ namespace mcts {
 
             new_mcts_->m_path.reset ( new_tree.root_arc, new_tree.root_node );
             new_mcts_->m_path_size = 1;
+            new_mcts_->m_is_reflected = isReflected ( state_ );
+
+            // Transfer the play-outs.
+
+            new_mcts_->m_no_playouts = m_no_playouts;
+            new_mcts_->m_playout_pool.reset ( m_playout_pool.take ( ) );
+        }
+
+
+        // Root parallelization, no_threads_ searches of a tree each (and a stream of the rng each),
+        // of an equal share of the iterations, without any contention. The trees are merged
+        // pairwise and in parallel, in rounds (log2 ( no_threads_ ) deep), the move is the best
+        // move of the merged tree. A learning Policy is shared by the searches (and aged once).
+
+        [[ nodiscard ]] static Move computeRootParallel ( const State & state_, const index_t max_iterations_ = 100'000, index_t no_threads_ = 0, const index_t no_playouts_ = default_no_playouts ) {
+            if ( no_threads_ < 1 ) {
+                no_threads_ = std::max ( 1, ( index_t ) getNumberOfProcessors ( ) );
+            }
+            if constexpr ( Policy::is_learning ) {
+                Policy::template age < typename State::BitState > ( );
+            }
+            std::vector < Mcts * > mcts ( no_threads_, nullptr );
+            auto work = [ & ] ( const index_t t_ ) {
+                mcts [ t_ ] = new Mcts ( );
+                mcts [ t_ ]->setPlayouts ( no_playouts_ );
+                mcts [ t_ ]->initialize ( state_ );
+                mcts [ t_ ]->grow ( state_, ( max_iterations_ + t_ ) / no_threads_, 1, Clock::time_point::max ( ) );
+            };
+            std::vector < std::thread > threads;
+            for ( index_t t = 1; t < no_threads_; ++t ) {
+                threads.emplace_back ( work, t );
+            }
+            work ( 0 );
+            for ( std::thread & thread : threads ) {
+                thread.join ( );
+            }
+            for ( index_t stride = 1; stride < no_threads_; stride *= 2 ) {
+                threads.clear ( );
+                for ( index_t t = stride; t < no_threads_; t += 2 * stride ) {
+                    threads.emplace_back ( [ & mcts, t, stride ] ( ) { merge ( mcts [ t - stride ], mcts [ t ] ); } );
+                }
+                for ( std::thread & thread : threads ) {
+                    thread.join ( );
+                }
+            }
+            const Move move = mcts [ 0 ]->getBestMove ( );
+            delete mcts [ 0 ];
+            return move;
         }
 
 
         static void prune ( Mcts * & old_mcts_, const State & state_ ) noexcept {
 
-            if ( not ( old_mcts_->m_not_initialized ) and old_mcts_->getNode ( state_.zobrist ( ) [ 0 ] ) != Mcts::Tree::invalid_node ) {
+            if ( not ( old_mcts_->m_not_initialized ) and old_mcts_->getNode ( key ( state_ ) ) != Mcts::Tree::invalid_node ) {
 
                 // The state exists in the tree and it's not the current root_node. i.e. now prune.
 
@@ -776,13 +1324,14 @@ namespace mcts {
 
             if ( not ( mcts_->m_not_initialized ) ) {
 
-                const Mcts::Node new_root_node = mcts_->getNode ( state_.zobrist ( ) [ 0 ] );
+                const Mcts::Node new_root_node = mcts_->getNode ( key ( state_ ) );
 
                 if ( new_root_node != Mcts::Tree::invalid_node ) {
 
                     // The state exists in the tree and it's not the current root_node. i.e. re-hang the tree.
 
                     mcts_->m_tree.setRoot ( new_root_node );
+                    mcts_->m_is_reflected = isReflected ( state_ );
 
                     if ( player_ == Player::Type::agent ) {
 
@@ -797,6 +1346,8 @@ namespace mcts {
                     Mcts * new_mcts = new Mcts ( );
 
                     new_mcts->initialize ( state_ );
+                    new_mcts->m_no_playouts = mcts_->m_no_playouts;
+                    new_mcts->m_playout_pool.reset ( mcts_->m_playout_pool.take ( ) );
 
                     std::swap ( mcts_, new_mcts );
 
@@ -810,10 +1361,7 @@ namespace mcts {
 
             InverseTranspositionTable itt ( m_transposition_table->size ( ) );
 
-            for ( auto & e : * m_transposition_table ) {
-
-                itt [ e.second ] = e.first;
-            }
+            m_transposition_table->forEach ( [ & itt ] ( const ZobristHash key_, const Node node_ ) { itt [ node_ ( ) ] = key_; } );
 
             return itt;
         }
@@ -849,7 +1397,11 @@ namespace mcts {
             Visited s_visited ( s_t.nodeNum ( ) );
             Queue s_queue ( s_t.root_node );
 
-            s_visited [ s_t.root_node ] = true;
+            s_visited [ s_t.root_node ( ) ] = true;
+
+            // The roots are the same position.
+
+            t_t [ t_t.root_node ] += s_t [ s_t.root_node ];
 
             // Walk the tree, breadth first.
 
@@ -857,57 +1409,64 @@ namespace mcts {
 
                 // The t_source (target parent) does always exist, as we are going at it breadth first.
 
-                const Node s_source = s_queue.pop ( ), t_source = t_tt.find ( s_itt [ s_source ] )->second;
+                const Node s_source = s_queue.pop ( ), t_source = t_tt.find ( s_itt [ s_source ( ) ] )->second;
 
-                // Iterate over children (targets) of the parent (source).
+                // Iterate over children (targets) of the parent (source), all arcs are merged, the values of a child once.
 
                 for ( OutIt soi ( s_t, s_source ); soi != OutIt::end ( ); ++soi ) { // Source Out Iterator (soi).
 
                     const Link s_link = s_t.link ( soi );
 
-                    if ( not ( s_visited [ s_link.target ] ) ) {
-
-                        s_visited [ s_link.target ] = true;
-                        s_queue.push ( s_link.target );
+                    // If child in s_mcts_ doesn't exist in t_mcts_, add child.
 
-                        // Now do something. If child in s_mcts_ doesn't exist in t_mcts_, add child.
+                    const auto t_it = t_tt.find ( s_itt [ s_link.target ( ) ] );
 
-                        const auto t_it = t_tt.find ( s_itt [ s_link.target ] );
+                    if ( t_it != t_tt.cend ( ) ) { // Child exists. The arc does or does not exist.
 
-                        if ( t_it != t_tt.cend ( ) ) { // Child exists. The arc does or does not exist.
+                        // Node t_it->second corresponds to Node target child.
 
-                            // Node t_it->second corresponds to Node target child.
+                        const Link t_link ( t_t.link ( t_source, t_it->second ) );
 
-                            const Link t_link ( t_t.link ( t_source, t_it->second ) );
+                        if ( t_link.arc != Tree::invalid_arc ) { // The arc does exist.
 
-                            if ( t_link.arc != Tree::invalid_arc ) { // The arc does exist.
+                            t_t [ t_link.arc ] += s_t [ s_link.arc ];
+                        }
 
-                                t_t [ t_link.arc ] += s_t [ s_link.arc ];
-                            }
+                        else { // The arc does not exist.
 
-                            else { // The arc does not exist.
+                            t_t [ t_t.addArcUnsafe ( t_source, t_link.target ).arc ] = s_t [ s_link.arc ];
+                        }
 
-                                t_t [ t_t.addArcUnsafe ( t_source, t_link.target ).arc ] = std::move ( s_t [ s_link.arc ] );
-                            }
+                        // Update the values of the target.
 
-                            // Update the values of the target.
+                        if ( not ( s_visited [ s_link.target ( ) ] ) ) {
 
                             t_t [ t_link.target ] += s_t [ s_link.target ];
                         }
+                    }
 
-                        else { // Child does not exist.
+                    else { // Child does not exist.
 
-                            const Link t_link = t_t.addNodeUnsafe ( t_source );
+                        const Link t_link = t_t.addNodeUnsafe ( t_source );
 
-                            // m_tree.
+                        // m_tree.
 
-                            t_t [ t_link.arc    ] = std::move ( s_t [ s_link.arc    ] );
-                            t_t [ t_link.target ] = std::move ( s_t [ s_link.target ] );
+                        t_t [ t_link.arc    ] = s_t [ s_link.arc ];
+                        t_t [ t_link.target ] = std::move ( s_t [ s_link.target ] );
 
-                            // m_transposition_table.
+                        // m_transposition_table.
 
-                            t_tt.emplace ( s_itt [ s_link.target ], t_link.target );
-                        }
+                        t_tt.emplace ( s_itt [ s_link.target ( ) ], t_link.target );
+                    }
+
+                    // A move tried in the source is no longer untried in the target.
+
+                    t_t [ t_source ].removeUntriedMove ( s_t [ s_link.arc ].m_move );
+
+                    if ( not ( s_visited [ s_link.target ( ) ] ) ) {
+
+                        s_visited [ s_link.target ( ) ] = true;
+                        s_queue.push ( s_link.target );
                     }
                 }
             }
@@ -34,19 +34,16 @@
 #include <memory>
 #include <random>
 #include <functional>
-
-template < typename Function >
-using function = std::function < Function >;
-
 #include <algorithm>
 #include <optional>
-
-using namespace std::placeholders;  // for _1, _2, _3.
+#include <variant>
 
 #include <boost/container/static_vector.hpp>
 
+#if not defined ( OSKA_HEADLESS )
 #include <spatial/idle_point_multimap.hpp>
 #include <spatial/neighbor_iterator.hpp>
+#endif
 
 #include <cereal/cereal.hpp>
 #include <cereal/archives/binary.hpp>
@@ -59,7 +56,9 @@ using namespace std::placeholders;  // for _1, _2, _3.
 #include "Globals.hpp"
 #include "player.hpp"
 #include "moves.hpp"
+#if not defined ( OSKA_HEADLESS )
 #include "ResourceData.hpp"
+#endif
 
 
 // ------------------------------------ OSKA ---------------------------------------
@@ -154,31 +153,29 @@ struct Move { // 4
 
     enum class type : std::int8_t { LeftCapture = -2, LeftMove, None, RightMove, RightCapture, Invalid, UnInitialised, NoMove, RootMove };
 
-    union {
-        struct {
-            Location m_from, m_to;
-        };
-        std::uint32_t v;
-    };
+    Location m_from, m_to;
 
-    Move ( ) noexcept : v ( invalid.v ) { }
+    Move ( ) noexcept : m_from ( 0, 0 ), m_to ( 0, 0 ) { } // All bits zero, as Move::invalid.
     Move ( Location && f_ ) noexcept : m_from ( std::move ( f_ ) ) { }
     Move ( const Location & f_, const Location & t_ ) noexcept : m_from ( f_ ), m_to ( t_ ) { }
     Move ( Location && f_, Location && t_ ) noexcept : m_from ( std::move ( f_ ) ), m_to ( std::move ( t_ ) ) { }
-    Move ( const Move & m_ ) noexcept : v ( m_.v ) { }
-    Move ( Move && m_ ) noexcept : v ( std::move ( m_.v ) ) { }
+    Move ( const Move & m_ ) noexcept = default;
+    Move ( Move && m_ ) noexcept = default;
 
-    [[ maybe_unused ]] Move & operator = ( const Move & rhs_ ) noexcept {
-        v = rhs_.v;
-        return *this;
+    [[ maybe_unused ]] Move & operator = ( const Move & rhs_ ) noexcept = default;
+
+    // The two locations as one word, for comparison.
+
+    [[ nodiscard ]] std::uint32_t value ( ) const noexcept {
+        return std::uint32_t ( m_from.v ) | std::uint32_t ( m_to.v ) << 16;
     }
 
     [[ nodiscard ]] bool operator == ( const Move & rhs_ ) const noexcept {
-        return v == rhs_.v;
+        return value ( ) == rhs_.value ( );
     }
 
     [[ nodiscard ]] bool operator != ( const Move & rhs_ ) const noexcept {
-        return v != rhs_.v;
+        return value ( ) != rhs_.value ( );
     }
     [[ nodiscard ]] bool isMove ( ) const noexcept {
         return m_to.r - m_from.r == 1 and std::abs ( m_to.c - m_from.c ) == index_t ( 1 );
@@ -198,6 +195,45 @@ const Move Move::root = Move ( Location ( -2, -2 ), Location ( -2, -2 ) );
 const Move Move::invalid;
 
 
+// A move in one byte, as stored in the search tree (arcs and untried moves), 4 * id + 2 *
+// capture + right, of the hexagon moved from, in the mover's perspective (as Move is). Stones
+// on the far row don't move, so the id is less than NO_HEXAGONS ( S ) - S (60 for S = 8),
+// the values from 253 are none, root and invalid. Converted by HexagonGeometry<S>.
+
+struct CompactMove { // 1
+
+    static const CompactMove none;
+    static const CompactMove root;
+    static const CompactMove invalid;
+
+    std::uint8_t v = 255;
+
+    CompactMove ( ) noexcept { }
+    explicit CompactMove ( const index_t v_ ) noexcept : v ( ( std::uint8_t ) v_ ) { }
+
+    [[ nodiscard ]] bool operator == ( const CompactMove & rhs_ ) const noexcept {
+        return v == rhs_.v;
+    }
+
+    [[ nodiscard ]] bool operator != ( const CompactMove & rhs_ ) const noexcept {
+        return v != rhs_.v;
+    }
+
+private:
+
+    friend class cereal::access;
+
+    template<class Archive>
+    void serialize ( Archive & ar_ ) {
+        ar_ ( v );
+    }
+};
+
+const CompactMove CompactMove::none = CompactMove ( 253 );
+const CompactMove CompactMove::root = CompactMove ( 254 );
+const CompactMove CompactMove::invalid = CompactMove ( 255 );
+
+
 #define NO_COLS( S ) ( S )
 #define NO_ROWS( S ) ( 2 * ( ( S ) - 2 ) + 1 )
 
@@ -210,6 +246,8 @@ const Move Move::invalid;
 #define NO_HEXAGONS( S ) ( ( ( S ) * ( ( S ) + 1 ) ) - 4 )
 
 
+#if not defined ( OSKA_HEADLESS ) // The hexagons on screen, the GUI only.
+
 typedef sf::Vector2f Point;
 
 
@@ -319,52 +357,214 @@ float Hexagon::m_center_l2radius;
 std::normal_distribution<float> Hexagon::m_disx;
 std::normal_distribution<float> Hexagon::m_disy;
 
+#endif
+
 
 using StoneID = boost::container::static_vector<std::int8_t, 8>;
 
 
+// Compile-time lookup tables, by hexagon-id (agent's perspective).
+
+template<index_t S>
+struct HexagonGeometry {
+
+    struct Cell { // 2
+        std::int8_t c = Location::invalid, r = Location::invalid;
+    };
+
+    struct Target { // 2, the jumped-over hexagon is the step target.
+        std::int8_t step = -1, jump = -1;
+    };
+
+    struct Tables {
+        Cell cell [ NO_HEXAGONS ( S ) ];
+        Target target [ NO_HEXAGONS ( S ) ] [ 2 ] [ 2 ]; // By id, Player::as_01index ( ) and left/right (from the player's perspective).
+        std::int8_t location_to_id [ OB_COLS ( S ) ] [ OB_ROWS ( S ) ];  // -1 off-board.
+    };
+
+private:
+
+    [[ nodiscard ]] static constexpr Tables build ( ) noexcept {
+        Tables t { };
+        auto & location_to_id = t.location_to_id;
+        for ( auto & column : location_to_id ) {
+            for ( auto & id : column ) {
+                id = -1;
+            }
+        }
+        // Same enumeration as OskaStateTemplate<S>::once_initialize ( ).
+        index_t r = 1, li = 1, ri = OB_COLS ( S ) - 1, id = 0;
+        for ( ; r < OB_ROWS ( S ) / 2; ++r, ++li, --ri ) {
+            for ( index_t c = li; c < ri; c += 2, ++id ) {
+                t.cell [ id ].c = ( std::int8_t ) c, t.cell [ id ].r = ( std::int8_t ) r, location_to_id [ c ] [ r ] = ( std::int8_t ) id;
+            }
+        }
+        for ( ; r < OB_ROWS ( S ) - 1; ++r, --li, ++ri ) {
+            for ( index_t c = li; c < ri; c += 2, ++id ) {
+                t.cell [ id ].c = ( std::int8_t ) c, t.cell [ id ].r = ( std::int8_t ) r, location_to_id [ c ] [ r ] = ( std::int8_t ) id;
+            }
+        }
+        // The agent moves down the board, the human up, in agent's perspective.
+        const index_t dc [ 2 ] [ 2 ] = { { 1, -1 }, { -1, 1 } }, dr [ 2 ] = { 1, -1 };
+        const auto lookup = [ & location_to_id ] ( const index_t c_, const index_t r_ ) {
+            return c_ >= 0 and c_ < OB_COLS ( S ) and r_ >= 0 and r_ < OB_ROWS ( S ) ? location_to_id [ c_ ] [ r_ ] : std::int8_t { -1 };
+        };
+        for ( id = 0; id < NO_HEXAGONS ( S ); ++id ) {
+            for ( index_t p = 0; p < 2; ++p ) {
+                for ( index_t d = 0; d < 2; ++d ) {
+                    t.target [ id ] [ p ] [ d ].step = lookup ( t.cell [ id ].c + dc [ p ] [ d ], t.cell [ id ].r + dr [ p ] );
+                    t.target [ id ] [ p ] [ d ].jump = lookup ( t.cell [ id ].c + 2 * dc [ p ] [ d ], t.cell [ id ].r + 2 * dr [ p ] );
+                }
+            }
+        }
+        return t;
+    }
+
+public:
+
+    static constexpr Tables tables = build ( );
+
+    static_assert ( 4 * ( NO_HEXAGONS ( S ) - S ) <= 253, "the moves don't fit CompactMove" );
+
+    // Move to CompactMove and back, both in the mover's perspective, left is to the higher column.
+
+    [[ nodiscard ]] static CompactMove compact ( const Move & m_ ) noexcept {
+        if ( m_.isMove ( ) or m_.isCapture ( ) ) {
+            return CompactMove ( 4 * tables.location_to_id [ m_.m_from.c ] [ m_.m_from.r ] + 2 * m_.isCapture ( ) + ( m_.m_to.c < m_.m_from.c ) );
+        }
+        return m_ == Move::none ? CompactMove::none : ( m_ == Move::root ? CompactMove::root : CompactMove::invalid );
+    }
+
+    [[ nodiscard ]] static Move expand ( const CompactMove m_ ) noexcept {
+        if ( m_.v >= CompactMove::none.v ) {
+            return m_ == CompactMove::none ? Move::none : ( m_ == CompactMove::root ? Move::root : Move::invalid );
+        }
+        const Cell from = tables.cell [ m_.v >> 2 ];
+        const index_t dr = 1 + ( ( m_.v >> 1 ) & 1 ), dc = m_.v & 1 ? -dr : dr;
+        return Move ( Location ( from.c, from.r ), Location ( from.c + dc, from.r + dr ) );
+    }
+};
+
+
+// Zobrist keys, by player and location (in the player's own perspective), generated at compile
+// time from a fixed seed. The hashes, and the trees and tables keyed by them, are the same in
+// every run, whatever was drawn from g_rng before.
+
+template<index_t S>
+struct ZobristKeys {
+
+    static constexpr std::uint64_t seed = 0x5d6f1b2a9c3e4f70ull + S;
+
+    struct Table {
+
+        ZobristHash key [ 2 ] [ OB_COLS ( S ) ] [ OB_ROWS ( S ) ];
+
+        [[ nodiscard ]] constexpr ZobristHash at ( const index_t p_, const index_t c_, const index_t r_ ) const noexcept {
+            return key [ p_ ] [ c_ ] [ r_ ];
+        }
+    };
+
+private:
+
+    [[ nodiscard ]] static constexpr Table build ( ) noexcept {
+        Table t { };
+        std::uint64_t n = 0;
+        for ( index_t p = 0; p < 2; ++p ) {
+            for ( index_t c = 0; c < OB_COLS ( S ); ++c ) {
+                for ( index_t r = 0; r < OB_ROWS ( S ); ++r ) {
+                    t.key [ p ] [ c ] [ r ] = splitmix64::at ( seed, n++ );
+                }
+            }
+        }
+        return t;
+    }
+
+public:
+
+    static constexpr Table table = build ( );
+};
+
+
+// What a move changes, besides the boards and the stone-lists, to take it back.
+
+struct UndoRecord { // 32
+
+    ZobristHash m_zobrist_hash, m_zobrist_reflected_hash;
+    Move m_last_move;
+    Player m_winner;
+    std::int8_t m_no_home_agent, m_no_home_human;
+    std::int8_t m_captured_id = -1, m_captured_index = -1; // Id and index in the opponent's stone-list, of the captured stone.
+};
+
+
+template<index_t S>
+class OskaBitStateTemplate;
+template<index_t S>
+class OskaPackedStateTemplate;
+
+namespace bb {
+    template<index_t S>
+    class Mobility;
+}
+
+namespace po {
+    struct Uniform;
+}
+
 template<index_t S>
 class OskaStateTemplate {
 
+    friend class OskaBitStateTemplate<S>;
+    friend class OskaPackedStateTemplate<S>;
+
 public:
 
     static constexpr index_t max_no_moves = 2 * S;
 
-    using Player = Player;
-    using ZobristHash = ZobristHash;
-    using Move = Move;
-    using Moves = Moves<Move, max_no_moves>;
+    using Player = ::Player;
+    using ZobristHash = ::ZobristHash;
+    using Move = ::Move;
+    using Moves = ::Moves<Move, max_no_moves>;
+    using UndoRecord = ::UndoRecord;
+    using CompactMove = ::CompactMove;               // As stored in the search tree, see compact ( ) and expand ( ).
+    using CompactMoves = ::Moves<CompactMove, max_no_moves>;
+    using BitState = OskaBitStateTemplate<S>;      // Of the play-outs.
+    using PlayoutPolicy = po::Uniform;             // The default of playout ( ), playouts ( ) and simulate ( ), see Playout.hpp.
 
 private:
 
-    using Hexagons = ma::Vector<Hexagon, NO_HEXAGONS ( S )>;
     using LocationToID = ma::MatrixRM<index_t, OB_COLS ( S ), OB_ROWS ( S )>;
     using IDToLocation = ma::Vector<Location, NO_HEXAGONS ( S )>;
     using Board = ma::MatrixRM<Player, OB_COLS ( S ), OB_ROWS ( S )>;
-    using ZobristHashKeys = ma::Cube<ZobristHash, 2, OB_COLS ( S ), OB_ROWS ( S )>;
 
+#if not defined ( OSKA_HEADLESS )
+    using Hexagons = ma::Vector<Hexagon, NO_HEXAGONS ( S )>;
     using PointArray = std::array<float, 2>;
     using PointToID = spatial::idle_point_multimap<2, PointArray, index_t>;
 
     static Hexagons m_hexagons;
     static PointToID m_point_to_id;				// Lookup table from Point to Hexagon-id.
+#endif
     static LocationToID m_location_to_id;		// Lookup table from Location to Hexagon-id.
     static IDToLocation m_id_to_location;		// Lookup table from Hexagon-id to Location.
 
     ZobristHash m_zobrist_hash = m_zobrist_player_keys [ ( index_t ) Player::Type::vacant ]; // Hash of the current m_board.
+    ZobristHash m_zobrist_reflected_hash = m_zobrist_player_keys [ ( index_t ) Player::Type::vacant ]; // Hash of the left-right reflection of m_board.
 
     Board m_agent_board, m_human_board;			// Board from agent's and human's perspective, respectively.
     StoneID m_agent_stone_id, m_human_stone_id; // Stones from agent's perspective.
 
     index_t m_no_home_agent = 0, m_no_home_human = 0;
 
+    bb::Mobility<S> m_mobility;                 // The stones as bitboards, for hasMoves ( ) in constant time.
+
     Player m_player_to_move = Player::random ( ), m_winner = Player::Type::invalid;
 
     Move m_last_move = Move::root;
 
     bool is_once_initialized = false;
 
-    static ZobristHashKeys m_zobrist_keys;
+    static constexpr const typename ZobristKeys<S>::Table & m_zobrist_keys = ZobristKeys<S>::table;
     static const ZobristHash m_zobrist_player_key_values [ 3 ];
     static const ZobristHash * m_zobrist_player_keys;
 
@@ -373,12 +573,10 @@ public:
     OskaStateTemplate ( ) noexcept {
     }
     OskaStateTemplate ( const OskaStateTemplate & s_ ) noexcept {
-        std::memcpy ( this, & s_, sizeof ( OskaStateTemplate ) );
+        std::memcpy ( ( void * ) this, & s_, sizeof ( OskaStateTemplate ) );
     }
 
     void once_initialize ( ) {
-        ResourceData resource_data ( S );
-        Hexagon::initialize ( resource_data.m_xara_hex_dim );
         // Set all fields of boards to Player::Type::invalid.
         index_t r, c;
         for ( r = 0; r < OB_ROWS ( S ); ++r ) {
@@ -387,51 +585,57 @@ public:
                 m_human_board.at ( c, r ) = m_agent_board.at ( c, r ) = Player::Type::invalid;
             }
         }
-        std::uniform_int_distribution<std::size_t> dist;
         // Top of the board.
         m_agent_stone_id.reserve ( S );
         index_t li = 1, ri = OB_COLS ( S ) - 1, id = 0;
-        float y = 0.5f * resource_data.m_xara_hex_dim.y + resource_data.m_margin;
         for ( r = 1; r < OB_ROWS ( S ) / 2; ++r, ++li, --ri ) {
             for ( c = li; c < ri; c += 2 ) {
-                m_hexagons.at ( id ) = std::move ( Hexagon ( Point ( c * 0.5f * resource_data.m_xara_hex_dim.x + resource_data.m_margin, y ) ) );
-                m_point_to_id.insert ( std::make_pair ( toArray ( m_hexagons.at ( id ).center ( ) ), id ) );
                 m_location_to_id.at ( c, r ) = id;
                 m_id_to_location.at ( id ) = std::move ( Location ( c, r ) );
                 m_human_board.at_r ( c, r ) = m_agent_board.at ( c, r ) = r == 1 ? Player::Type::agent : Player::Type::vacant;
-                m_zobrist_keys.at ( 0, c, r ) = dist ( g_rng );
-                m_zobrist_keys.at ( 1, c, r ) = dist ( g_rng );
                 if ( r == 1 ) {
-                    const Player player = Player::Type::agent;
-                    m_zobrist_hash ^= m_zobrist_keys.at ( player.as_01index ( ), c, r );
                     m_agent_stone_id.emplace_back ( id );
                 }
                 ++id;
             }
-            y += 0.75f * resource_data.m_xara_hex_dim.y;
         }
         // Bottom of the board, r, li and ri "fall through" from top of board.
         m_human_stone_id.reserve ( S );
         for ( ; r < OB_ROWS ( S ) - 1; ++r, --li, ++ri ) {
             for ( c = li; c < ri; c += 2 ) {
-                m_hexagons.at ( id ) = std::move ( Hexagon ( Point ( c * 0.5f * resource_data.m_xara_hex_dim.x + resource_data.m_margin, y ) ) );
-                m_point_to_id.insert ( std::make_pair ( toArray ( m_hexagons.at ( id ).center ( ) ), id ) );
                 m_location_to_id.at ( c, r ) = id;
                 m_id_to_location.at ( id ) = std::move ( Location ( c, r ) );
                 m_human_board.at_r ( c, r ) = m_agent_board.at ( c, r ) = r == OB_HOME_ROW ( S ) ? Player::Type::human : Player::Type::vacant;
-                m_zobrist_keys.at ( 0, c, r ) = dist ( g_rng );
-                m_zobrist_keys.at ( 1, c, r ) = dist ( g_rng );
                 if ( r == OB_HOME_ROW ( S ) ) {
-                    const Player player = Player::Type::human;
-                    m_zobrist_hash ^= m_zobrist_keys.at ( player.as_01index ( ), c, r );
                     m_human_stone_id.emplace_back ( id );
                 }
                 ++id;
             }
-            y += 0.75f * resource_data.m_xara_hex_dim.y;
+        }
+#if not defined ( OSKA_HEADLESS )
+        once_initialize_hexagons ( );
+#endif
+        rehash ( );
+        remobilize ( );
+    }
+
+#if not defined ( OSKA_HEADLESS )
+    void once_initialize_hexagons ( ) {
+        // The hexagons on screen, by id, the ids run row by row.
+        ResourceData resource_data ( S );
+        Hexagon::initialize ( resource_data.m_xara_hex_dim );
+        float y = 0.5f * resource_data.m_xara_hex_dim.y + resource_data.m_margin;
+        for ( index_t id = 0; id < NO_HEXAGONS ( S ); ++id ) {
+            const Location l = m_id_to_location.at ( id );
+            if ( id and l.r != m_id_to_location.at ( id - 1 ).r ) {
+                y += 0.75f * resource_data.m_xara_hex_dim.y;
+            }
+            m_hexagons.at ( id ) = std::move ( Hexagon ( Point ( l.c * 0.5f * resource_data.m_xara_hex_dim.x + resource_data.m_margin, y ) ) );
+            m_point_to_id.insert ( std::make_pair ( toArray ( m_hexagons.at ( id ).center ( ) ), id ) );
         }
         m_point_to_id.rebalance ( );
     }
+#endif
 
     void initialize ( ) {
         if ( not ( is_once_initialized ) ) {
@@ -472,12 +676,50 @@ public:
         m_player_to_move = Player::random ( );
         m_winner = Player::Type::invalid;
         m_last_move = Move::root;
+        rehash ( );
+        remobilize ( );
+    }
+
+    void initialize ( const Player player_to_move_ ) {
+        // The initial position, with the given player to move first.
+        initialize ( );
+        m_player_to_move = player_to_move_;
+    }
+
+private:
+
+    void rehash ( ) noexcept {
+        // Hash of the stones, the stones of the human are keyed in human's perspective (as in moveStoneHash ( )).
+        m_zobrist_hash = m_zobrist_reflected_hash = m_zobrist_player_keys [ ( index_t ) Player::Type::vacant ];
+        for ( const index_t s : m_agent_stone_id ) {
+            const Location l = m_id_to_location.at ( s ), m = reflect ( l );
+            m_zobrist_hash ^= m_zobrist_keys.at ( 0, l.c, l.r );
+            m_zobrist_reflected_hash ^= m_zobrist_keys.at ( 0, m.c, m.r );
+        }
+        for ( const index_t s : m_human_stone_id ) {
+            const Location l = m_id_to_location.at_r ( s ), m = reflect ( l );
+            m_zobrist_hash ^= m_zobrist_keys.at ( 1, l.c, l.r );
+            m_zobrist_reflected_hash ^= m_zobrist_keys.at ( 1, m.c, m.r );
+        }
+    }
+
+    void remobilize ( ) noexcept {
+        m_mobility.clear ( );
+        for ( const index_t s : m_agent_stone_id ) {
+            m_mobility.flip ( 0, s );
+        }
+        for ( const index_t s : m_human_stone_id ) {
+            m_mobility.flip ( 1, s );
+        }
     }
 
+public:
+
     [[ nodiscard ]] bool isValidID ( const std::int8_t id_ ) const noexcept {
         return id_ >= 0 and id_ < NO_HEXAGONS ( S );
     }
 
+#if not defined ( OSKA_HEADLESS )
     [[ nodiscard ]] PointArray toArray ( const sf::Vector2f & v_ ) const noexcept {
         return * reinterpret_cast < const PointArray * > ( & v_ );
     }
@@ -505,6 +747,7 @@ public:
     [[ nodiscard ]] Hexagon & getHexRefFromID ( const index_t i_ ) noexcept {
         return m_hexagons.at ( i_ );
     }
+#endif
 
     [[ nodiscard ]] index_t getIdFromLocation ( const Location & l_ ) const noexcept {
         // Agents' view.
@@ -528,13 +771,25 @@ public:
     }
 
     [[ nodiscard ]] bool haveRemainingHome ( const Player player_ ) const noexcept {
-        return player_ == Player::Type::agent ? ( m_no_home_agent and ( m_no_home_agent == m_agent_stone_id.size ( ) ) ) : ( m_no_home_human and ( m_no_home_human == m_human_stone_id.size ( ) ) );
+        return player_ == Player::Type::agent ? ( m_no_home_agent and ( m_no_home_agent == ( index_t ) m_agent_stone_id.size ( ) ) ) : ( m_no_home_human and ( m_no_home_human == ( index_t ) m_human_stone_id.size ( ) ) );
     }
 
     [[ nodiscard ]] ZobristHash zobrist ( ) const noexcept {
         return m_zobrist_hash ^ m_zobrist_player_keys [ m_player_to_move.as_index ( ) ]; // m_player_to_move is opposite player, doesn't matter for the ZH.
     }
 
+    // The board is symmetric under left-right reflection, the canonical hash is the same for a
+    // position and its reflection, isReflected ( ) tells whether this is the position (of the two)
+    // with the higher hash, i.e. whether moves should be reflected to the canonical orientation.
+
+    [[ nodiscard ]] ZobristHash canonical ( ) const noexcept {
+        return std::min ( m_zobrist_hash, m_zobrist_reflected_hash ) ^ m_zobrist_player_keys [ m_player_to_move.as_index ( ) ];
+    }
+
+    [[ nodiscard ]] bool isReflected ( ) const noexcept {
+        return m_zobrist_reflected_hash < m_zobrist_hash;
+    }
+
     [[ nodiscard ]] Player playerToMove ( ) const noexcept {
         return m_player_to_move;
     }
@@ -572,63 +827,39 @@ public:
         return Location ( ( OB_COLS ( S ) - 1 ), ( OB_ROWS ( S ) - 1 ) ) - l_;
     }
 
+    [[ nodiscard ]] static CompactMove compact ( const Move & m_ ) noexcept {
+        return HexagonGeometry<S>::compact ( m_ );
+    }
+
+    [[ nodiscard ]] static Move expand ( const CompactMove m_ ) noexcept {
+        return HexagonGeometry<S>::expand ( m_ );
+    }
+
+    // Left-right reflected location and move, the same in either player's perspective.
+
+    [[ nodiscard ]] static Location reflect ( const Location & l_ ) noexcept {
+        return Location ( ( OB_COLS ( S ) - 1 ) - l_.c, l_.r );
+    }
+
+    [[ nodiscard ]] static Move reflect ( const Move & m_ ) noexcept {
+        return Move ( reflect ( m_.m_from ), reflect ( m_.m_to ) );
+    }
+
     [[ nodiscard ]] Move const randomMove ( ) const noexcept {
         Move move;
-        if ( m_player_to_move == Player::Type::agent ) {
-            StoneID ids ( m_agent_stone_id );
-            while ( ids.size ( ) ) {
-                const index_t i = std::uniform_int_distribution<index_t> ( 0, ( index_t ) ids.size ( ) - 1 ) ( g_rng );
-                const Location loc = m_id_to_location.at ( ids [ i ] );
-                if ( bernoulli ( ) ) {
-                    move = leftMove ( m_agent_board, loc.c, loc.r );
-                    if ( move not_eq Move::invalid ) {
-                        return move;
-                    }
-                    move = rightMove ( m_agent_board, loc.c, loc.r );
-                    if ( move not_eq Move::invalid ) {
-                        return move;
-                    }
-                }
-                else {
-                    move = rightMove ( m_agent_board, loc.c, loc.r );
-                    if ( move not_eq Move::invalid ) {
-                        return move;
-                    }
-                    move = leftMove ( m_agent_board, loc.c, loc.r );
-                    if ( move not_eq Move::invalid ) {
-                        return move;
-                    }
-                }
-                ids.erase ( std::begin ( ids ) + i );
+        StoneID ids ( m_player_to_move == Player::Type::agent ? m_agent_stone_id : m_human_stone_id );
+        while ( ids.size ( ) ) {
+            const index_t i = std::uniform_int_distribution<index_t> ( 0, ( index_t ) ids.size ( ) - 1 ) ( g_rng );
+            const index_t d = bernoulli ( );
+            move = stoneMove ( m_player_to_move, ids [ i ], d );
+            if ( move not_eq Move::invalid ) {
+                return move;
             }
-        }
-        else {
-            StoneID ids ( m_human_stone_id );
-            while ( ids.size ( ) ) {
-                const index_t i = std::uniform_int_distribution<index_t> ( 0, ( index_t ) ids.size ( ) - 1 ) ( g_rng );
-                const Location loc = m_id_to_location.at_r ( ids [ i ] );
-                if ( bernoulli ( ) ) {
-                    move = leftMove ( m_human_board, loc.c, loc.r );
-                    if ( move not_eq Move::invalid ) {
-                        return move;
-                    }
-                    move = rightMove ( m_human_board, loc.c, loc.r );
-                    if ( move not_eq Move::invalid ) {
-                        return move;
-                    }
-                }
-                else {
-                    move = rightMove ( m_human_board, loc.c, loc.r );
-                    if ( move not_eq Move::invalid ) {
-                        return move;
-                    }
-                    move = leftMove ( m_human_board, loc.c, loc.r );
-                    if ( move not_eq Move::invalid ) {
-                        return move;
-                    }
-                }
-                ids.erase ( std::begin ( ids ) + i );
+            move = stoneMove ( m_player_to_move, ids [ i ], d ^ 1 );
+            if ( move not_eq Move::invalid ) {
+                return move;
             }
+            ids.erase ( std::begin ( ids ) + i );
         }
         return move;
     }
@@ -665,17 +896,25 @@ private:
         if ( player_ == Player::Type::agent ) {
             m_agent_board.at ( move_.m_from.c, move_.m_from.r ) = m_human_board.at_r ( move_.m_from.c, move_.m_from.r ) = Player::Type::vacant;
             m_agent_board.at ( move_.m_to.c, move_.m_to.r ) = m_human_board.at_r ( move_.m_to.c, move_.m_to.r ) = Player::Type::agent;
-            ( *std::find ( std::begin ( m_agent_stone_id ), std::end ( m_agent_stone_id ), m_location_to_id.at ( move_.m_from.c, move_.m_from.r ) ) ) = m_location_to_id.at ( move_.m_to.c, move_.m_to.r );
+            const index_t from = m_location_to_id.at ( move_.m_from.c, move_.m_from.r ), to = m_location_to_id.at ( move_.m_to.c, move_.m_to.r );
+            ( *std::find ( std::begin ( m_agent_stone_id ), std::end ( m_agent_stone_id ), from ) ) = to;
+            m_mobility.move ( 0, from, to );
             m_zobrist_hash ^= m_zobrist_keys.at ( 0, move_.m_from.c, move_.m_from.r );
             m_zobrist_hash ^= m_zobrist_keys.at ( 0, move_.m_to.c, move_.m_to.r );
+            m_zobrist_reflected_hash ^= m_zobrist_keys.at ( 0, ( OB_COLS ( S ) - 1 ) - move_.m_from.c, move_.m_from.r );
+            m_zobrist_reflected_hash ^= m_zobrist_keys.at ( 0, ( OB_COLS ( S ) - 1 ) - move_.m_to.c, move_.m_to.r );
             m_no_home_agent += move_.m_to.r == OB_HOME_ROW ( S );
         }
         else {
             m_human_board.at ( move_.m_from.c, move_.m_from.r ) = m_agent_board.at_r ( move_.m_from.c, move_.m_from.r ) = Player::Type::vacant;
             m_human_board.at ( move_.m_to.c, move_.m_to.r ) = m_agent_board.at_r ( move_.m_to.c, move_.m_to.r ) = Player::Type::human;
-            ( *std::find ( std::begin ( m_human_stone_id ), std::end ( m_human_stone_id ), m_location_to_id.at_r ( move_.m_from.c, move_.m_from.r ) ) ) = m_location_to_id.at_r ( move_.m_to.c, move_.m_to.r );
+            const index_t from = m_location_to_id.at_r ( move_.m_from.c, move_.m_from.r ), to = m_location_to_id.at_r ( move_.m_to.c, move_.m_to.r );
+            ( *std::find ( std::begin ( m_human_stone_id ), std::end ( m_human_stone_id ), from ) ) = to;
+            m_mobility.move ( 1, from, to );
             m_zobrist_hash ^= m_zobrist_keys.at ( 1, move_.m_from.c, move_.m_from.r );
             m_zobrist_hash ^= m_zobrist_keys.at ( 1, move_.m_to.c, move_.m_to.r );
+            m_zobrist_reflected_hash ^= m_zobrist_keys.at ( 1, ( OB_COLS ( S ) - 1 ) - move_.m_from.c, move_.m_from.r );
+            m_zobrist_reflected_hash ^= m_zobrist_keys.at ( 1, ( OB_COLS ( S ) - 1 ) - move_.m_to.c, move_.m_to.r );
             m_no_home_human += move_.m_to.r == OB_HOME_ROW ( S );
         }
     }
@@ -685,12 +924,16 @@ private:
         if ( player_ == Player::Type::agent ) {
             m_agent_board.at ( captured.c, captured.r ) = m_human_board.at_r ( captured.c, captured.r ) = Player::Type::vacant;
             m_human_stone_id.erase ( std::remove ( std::begin ( m_human_stone_id ), std::end ( m_human_stone_id ), m_location_to_id.at ( captured.c, captured.r ) ), std::end ( m_human_stone_id ) );
+            m_mobility.flip ( 1, m_location_to_id.at ( captured.c, captured.r ) );
             m_zobrist_hash ^= m_zobrist_keys.at ( 1, ( OB_COLS ( S ) - 1 ) - captured.c, ( OB_ROWS ( S ) - 1 ) - captured.r );
+            m_zobrist_reflected_hash ^= m_zobrist_keys.at ( 1, captured.c, ( OB_ROWS ( S ) - 1 ) - captured.r );
         }
         else {
             m_human_board.at ( captured.c, captured.r ) = m_agent_board.at_r ( captured.c, captured.r ) = Player::Type::vacant;
             m_agent_stone_id.erase ( std::remove ( std::begin ( m_agent_stone_id ), std::end ( m_agent_stone_id ), m_location_to_id.at_r ( captured.c, captured.r ) ), std::end ( m_agent_stone_id ) );
+            m_mobility.flip ( 0, m_location_to_id.at_r ( captured.c, captured.r ) );
             m_zobrist_hash ^= m_zobrist_keys.at ( 0, ( OB_COLS ( S ) - 1 ) - captured.c, ( OB_ROWS ( S ) - 1 ) - captured.r );
+            m_zobrist_reflected_hash ^= m_zobrist_keys.at ( 0, captured.c, ( OB_ROWS ( S ) - 1 ) - captured.r );
         }
     }
 
@@ -699,13 +942,17 @@ private:
         if ( player_ == Player::Type::agent ) {
             m_agent_board.at ( move_.m_from.c, move_.m_from.r ) = m_human_board.at_r ( move_.m_from.c, move_.m_from.r ) = Player::Type::vacant;
             m_agent_board.at ( move_.m_to.c, move_.m_to.r ) = m_human_board.at_r ( move_.m_to.c, move_.m_to.r ) = Player::Type::agent;
-            ( *std::find ( std::begin ( m_agent_stone_id ), std::end ( m_agent_stone_id ), m_location_to_id.at ( move_.m_from.c, move_.m_from.r ) ) ) = m_location_to_id.at ( move_.m_to.c, move_.m_to.r );
+            const index_t from = m_location_to_id.at ( move_.m_from.c, move_.m_from.r ), to = m_location_to_id.at ( move_.m_to.c, move_.m_to.r );
+            ( *std::find ( std::begin ( m_agent_stone_id ), std::end ( m_agent_stone_id ), from ) ) = to;
+            m_mobility.move ( 0, from, to );
             m_no_home_agent += move_.m_to.r == OB_HOME_ROW ( S );
         }
         else {
             m_human_board.at ( move_.m_from.c, move_.m_from.r ) = m_agent_board.at_r ( move_.m_from.c, move_.m_from.r ) = Player::Type::vacant;
             m_human_board.at ( move_.m_to.c, move_.m_to.r ) = m_agent_board.at_r ( move_.m_to.c, move_.m_to.r ) = Player::Type::human;
-            ( *std::find ( std::begin ( m_human_stone_id ), std::end ( m_human_stone_id ), m_location_to_id.at_r ( move_.m_from.c, move_.m_from.r ) ) ) = m_location_to_id.at_r ( move_.m_to.c, move_.m_to.r );
+            const index_t from = m_location_to_id.at_r ( move_.m_from.c, move_.m_from.r ), to = m_location_to_id.at_r ( move_.m_to.c, move_.m_to.r );
+            ( *std::find ( std::begin ( m_human_stone_id ), std::end ( m_human_stone_id ), from ) ) = to;
+            m_mobility.move ( 1, from, to );
             m_no_home_human += move_.m_to.r == OB_HOME_ROW ( S );
         }
     }
@@ -715,10 +962,12 @@ private:
         if ( player_ == Player::Type::agent ) {
             m_agent_board.at ( captured.c, captured.r ) = m_human_board.at_r ( captured.c, captured.r ) = Player::Type::vacant;
             m_human_stone_id.erase ( std::remove ( std::begin ( m_human_stone_id ), std::end ( m_human_stone_id ), m_location_to_id.at ( captured.c, captured.r ) ), std::end ( m_human_stone_id ) );
+            m_mobility.flip ( 1, m_location_to_id.at ( captured.c, captured.r ) );
         }
         else {
             m_human_board.at ( captured.c, captured.r ) = m_agent_board.at_r ( captured.c, captured.r ) = Player::Type::vacant;
             m_agent_stone_id.erase ( std::remove ( std::begin ( m_agent_stone_id ), std::end ( m_agent_stone_id ), m_location_to_id.at_r ( captured.c, captured.r ) ), std::end ( m_agent_stone_id ) );
+            m_mobility.flip ( 0, m_location_to_id.at_r ( captured.c, captured.r ) );
         }
     }
 
@@ -760,45 +1009,120 @@ public:
     }
 
 
-    // Search forward (from Player's perspective), left and right,
-    // returning a potential move, either move or capture.
+    // As move_hash ( ) and move_hash_winner ( ), saving what's needed to unmake ( ) the move.
 
-    [ [ nodiscard ] ] Move leftMove ( const Board & b_, index_t c_, index_t r_ ) const noexcept { // Location is in players's perspective.
-        Move move ( Location ( c_, r_ ) );
-        ++c_; ++r_;
-        const Player player = b_.at ( c_, r_ );
-        if ( player == Player::Type::vacant ) { // ExtendedMove.
-            move.m_to = std::move ( Location ( c_, r_ ) );
-            return move;
+    void make_hash ( const Move & move_, UndoRecord & undo_ ) noexcept {
+        save ( move_, undo_ );
+        move_hash ( move_ );
+    }
+
+    void make_hash_winner ( const Move & move_, UndoRecord & undo_ ) noexcept {
+        save ( move_, undo_ );
+        move_hash_winner ( move_ );
+    }
+
+    void unmake ( const Move & move_, const UndoRecord & undo_ ) noexcept {
+        m_player_to_move.next ( );
+        const Player opponent = m_player_to_move.opponent ( );
+        place ( m_player_to_move, move_.m_from, m_player_to_move );
+        place ( m_player_to_move, move_.m_to, Player::Type::vacant );
+        if ( m_player_to_move == Player::Type::agent ) {
+            const index_t from = m_location_to_id.at ( move_.m_from.c, move_.m_from.r ), to = m_location_to_id.at ( move_.m_to.c, move_.m_to.r );
+            ( *std::find ( std::begin ( m_agent_stone_id ), std::end ( m_agent_stone_id ), to ) ) = from;
+            m_mobility.move ( 0, to, from );
         }
-        else if ( player == b_.at ( move.m_from.c, move.m_from.r ).opponent ( ) ) { // Capture.
-            ++c_; ++r_;
-            if ( b_.at ( c_, r_ ) == Player::Type::vacant ) {
-                move.m_to = std::move ( Location ( c_, r_ ) );
-                return move;
-            }
+        else {
+            const index_t from = m_location_to_id.at_r ( move_.m_from.c, move_.m_from.r ), to = m_location_to_id.at_r ( move_.m_to.c, move_.m_to.r );
+            ( *std::find ( std::begin ( m_human_stone_id ), std::end ( m_human_stone_id ), to ) ) = from;
+            m_mobility.move ( 1, to, from );
         }
-        return Move::invalid;
+        if ( undo_.m_captured_index >= 0 ) {
+            place ( m_player_to_move, move_.captured ( ), opponent );
+            StoneID & ids = opponent == Player::Type::agent ? m_agent_stone_id : m_human_stone_id;
+            ids.insert ( std::begin ( ids ) + undo_.m_captured_index, undo_.m_captured_id );
+            m_mobility.flip ( opponent.as_01index ( ), undo_.m_captured_id );
+        }
+        m_zobrist_hash = undo_.m_zobrist_hash;
+        m_zobrist_reflected_hash = undo_.m_zobrist_reflected_hash;
+        m_last_move = undo_.m_last_move;
+        m_winner = undo_.m_winner;
+        m_no_home_agent = undo_.m_no_home_agent;
+        m_no_home_human = undo_.m_no_home_human;
     }
 
-    [[ nodiscard ]] Move rightMove ( const Board & b_, index_t c_, index_t r_ ) const noexcept { // Location is in Player's perspective.
-        Move move ( Location ( c_, r_ ) );
-        --c_; ++r_;
-        const Player player = b_.at ( c_, r_ );
+private:
+
+    void save ( const Move & move_, UndoRecord & undo_ ) const noexcept {
+        undo_.m_zobrist_hash = m_zobrist_hash;
+        undo_.m_zobrist_reflected_hash = m_zobrist_reflected_hash;
+        undo_.m_last_move = m_last_move;
+        undo_.m_winner = m_winner;
+        undo_.m_no_home_agent = ( std::int8_t ) m_no_home_agent;
+        undo_.m_no_home_human = ( std::int8_t ) m_no_home_human;
+        if ( move_.isCapture ( ) ) {
+            const Location captured = move_.captured ( );
+            const StoneID & ids = m_player_to_move == Player::Type::agent ? m_human_stone_id : m_agent_stone_id;
+            undo_.m_captured_id = ( std::int8_t ) ( m_player_to_move == Player::Type::agent ? m_location_to_id.at ( captured.c, captured.r ) : m_location_to_id.at_r ( captured.c, captured.r ) );
+            undo_.m_captured_index = ( std::int8_t ) ( std::find ( std::begin ( ids ), std::end ( ids ), undo_.m_captured_id ) - std::begin ( ids ) );
+        }
+        else {
+            undo_.m_captured_id = undo_.m_captured_index = -1;
+        }
+    }
+
+    void place ( const Player player_, const Location & l_, const Player value_ ) noexcept {
+        // Location is in player's perspective.
+        if ( player_ == Player::Type::agent ) {
+            m_agent_board.at ( l_.c, l_.r ) = m_human_board.at_r ( l_.c, l_.r ) = value_;
+        }
+        else {
+            m_human_board.at ( l_.c, l_.r ) = m_agent_board.at_r ( l_.c, l_.r ) = value_;
+        }
+    }
+
+public:
+
+
+    // Location of the hexagon-id, from the perspective of the player.
+
+    [[ nodiscard ]] static Location location ( const index_t p_, const index_t id_ ) noexcept {
+        const typename HexagonGeometry<S>::Cell & cell = HexagonGeometry<S>::tables.cell [ p_ ? ( NO_HEXAGONS ( S ) - 1 ) - id_ : id_ ];
+        return Location ( cell.c, cell.r );
+    }
+
+    [[ nodiscard ]] Player at ( const index_t id_ ) const noexcept {
+        const typename HexagonGeometry<S>::Cell & cell = HexagonGeometry<S>::tables.cell [ id_ ];
+        return m_agent_board.at ( cell.c, cell.r );
+    }
+
+
+    // Search forward (from Player's perspective), left (0) or right (1) of the
+    // stone at hexagon-id, returning a potential move, either move or capture.
+
+    [[ nodiscard ]] Move stoneMove ( const Player player_, const index_t id_, const index_t d_ ) const noexcept {
+        const index_t p = player_.as_01index ( );
+        const typename HexagonGeometry<S>::Target & target = HexagonGeometry<S>::tables.target [ id_ ] [ p ] [ d_ ];
+        if ( target.step < 0 ) {
+            return Move::invalid;
+        }
+        const Player player = at ( target.step );
         if ( player == Player::Type::vacant ) { // ExtendedMove.
-            move.m_to = std::move ( Location ( c_, r_ ) );
-            return move;
+            return Move ( location ( p, id_ ), location ( p, target.step ) );
         }
-        else if ( player == b_.at ( move.m_from.c, move.m_from.r ).opponent ( ) ) { // Capture.
-            --c_; ++r_;
-            if ( b_.at ( c_, r_ ) == Player::Type::vacant ) {
-                move.m_to = std::move ( Location ( c_, r_ ) );
-                return move;
-            }
+        if ( player == player_.opponent ( ) and target.jump >= 0 and at ( target.jump ) == Player::Type::vacant ) { // Capture.
+            return Move ( location ( p, id_ ), location ( p, target.jump ) );
         }
         return Move::invalid;
     }
 
+    [[ nodiscard ]] Move leftMove ( const Player player_, const index_t id_ ) const noexcept {
+        return stoneMove ( player_, id_, 0 );
+    }
+
+    [[ nodiscard ]] Move rightMove ( const Player player_, const index_t id_ ) const noexcept {
+        return stoneMove ( player_, id_, 1 );
+    }
+
     [[ nodiscard ]] bool moves ( Moves * moves_ ) const noexcept {
         // Mcts class takes has ownership.
         if ( m_winner.occupied ( ) ) {
@@ -806,68 +1130,42 @@ public:
         }
         moves_->clear ( );
         Move move;
-        if ( m_player_to_move == Player::Type::agent ) {
-            for ( const index_t s : m_agent_stone_id ) {
-                const Location l = m_id_to_location.at ( s );
-                move = leftMove ( m_agent_board, l.c, l.r );
-                if ( move not_eq Move::invalid ) {
-                    moves_->push_back ( move );
-                }
-                move = rightMove ( m_agent_board, l.c, l.r );
-                if ( move not_eq Move::invalid ) {
-                    moves_->push_back ( move );
-                }
+        for ( const index_t s : m_player_to_move == Player::Type::agent ? m_agent_stone_id : m_human_stone_id ) {
+            move = leftMove ( m_player_to_move, s );
+            if ( move not_eq Move::invalid ) {
+                moves_->push_back ( move );
             }
-        }
-        else {
-            for ( const index_t s : m_human_stone_id ) {
-                const Location l = m_id_to_location.at_r ( s );
-                move = leftMove ( m_human_board, l.c, l.r );
-                if ( move not_eq Move::invalid ) {
-                    moves_->push_back ( move );
-                }
-                move = rightMove ( m_human_board, l.c, l.r );
-                if ( move not_eq Move::invalid ) {
-                    moves_->push_back ( move );
-                }
+            move = rightMove ( m_player_to_move, s );
+            if ( move not_eq Move::invalid ) {
+                moves_->push_back ( move );
             }
         }
         return moves_->size ( );
     }
 
 
+    template<typename Policy = PlayoutPolicy>
+    [[ nodiscard ]] Player playout ( ) const noexcept {
+        // The winner of a play-out, with moves picked by the Policy, done on a bitboard copy, this state is left unchanged.
+        OskaBitStateTemplate<S> state ( * this );
+        state.template simulate<Policy> ( );
+        return * state.ended ( );
+    }
+
+    template<typename Policy = PlayoutPolicy, index_t N>
+    void playouts ( Player ( & winners_ ) [ N ] ) const noexcept {
+        // N play-outs, uniformly random ones in lock-step (see bb::BatchPlayout), this state is left unchanged.
+        OskaBitStateTemplate<S> ( * this ).template playouts<Policy> ( winners_ );
+    }
+
+    template<typename Policy = PlayoutPolicy>
     void simulate ( ) noexcept {
-        Moves m;
-        while ( moves ( & m ) ) {
-            move_winner ( m.random ( ) );
-        }
+        m_winner = playout<Policy> ( );
     }
 
 
     [[ nodiscard ]] bool hasMoves ( const Player player_ ) const noexcept {
-        if ( player_ == Player::Type::agent ) {
-            for ( const index_t s : m_agent_stone_id ) {
-                const Location l = m_id_to_location.at ( s );
-                if ( leftMove ( m_agent_board, l.c, l.r ) not_eq Move::invalid ) {
-                    return true;
-                }
-                if ( rightMove ( m_agent_board, l.c, l.r ) not_eq Move::invalid ) {
-                    return true;
-                }
-            }
-        }
-        else {
-            for ( const index_t s : m_human_stone_id ) {
-                const Location l = m_id_to_location.at_r ( s );
-                if ( leftMove ( m_human_board, l.c, l.r ) not_eq Move::invalid ) {
-                    return true;
-                }
-                if ( rightMove ( m_human_board, l.c, l.r ) not_eq Move::invalid ) {
-                    return true;
-                }
-            }
-        }
-        return false;
+        return m_mobility.hasMoves ( player_.as_01index ( ) );
     }
 
     [[ nodiscard ]] bool hasNoMoves ( const Player player_ ) const noexcept {
@@ -907,7 +1205,11 @@ public:
     [[ nodiscard ]] float result ( const Player player_just_moved_ ) const noexcept {
         // Determine result: last player of path is the player to move.
         // return m_winner.vacant ( ) ? 0.5f : ( m_winner == player_just_moved_ ? 1.0f : 0.0f ); // Score.
-        return m_winner.vacant ( ) ? 0.0f : ( m_winner == player_just_moved_ ? 1.0f : -1.0f );
+        return score ( m_winner, player_just_moved_ );
+    }
+
+    [[ nodiscard ]] static float score ( const Player winner_, const Player player_just_moved_ ) noexcept {
+        return winner_.vacant ( ) ? 0.0f : ( winner_ == player_just_moved_ ? 1.0f : -1.0f );
     }
 
 
@@ -961,17 +1263,17 @@ private:
     void serialize ( Archive & ar_ ) { ar_ ( * this ); }
 };
 
+#if not defined ( OSKA_HEADLESS )
 template <index_t S>
 typename OskaStateTemplate<S>::Hexagons OskaStateTemplate<S>::m_hexagons;
 template <index_t S>
 typename OskaStateTemplate<S>::PointToID OskaStateTemplate<S>::m_point_to_id;
+#endif
 template <index_t S>
 typename OskaStateTemplate<S>::LocationToID OskaStateTemplate<S>::m_location_to_id;
 template <index_t S>
 typename OskaStateTemplate<S>::IDToLocation OskaStateTemplate<S>::m_id_to_location;
 template <index_t S>
-typename OskaStateTemplate<S>::ZobristHashKeys OskaStateTemplate<S>::m_zobrist_keys;
-template <index_t S>
 const typename OskaStateTemplate<S>::ZobristHash OskaStateTemplate<S>::m_zobrist_player_key_values [ 3 ] {
     0x41fec34015a1bef2ull, 0x8b80677c9c144514ull, 0xf6242292160d5bb7ull
 };
@@ -981,170 +1283,81 @@ const typename OskaStateTemplate<S>::ZobristHash * OskaStateTemplate<S>::m_zobri
 };
 
 
-#if 1
+#include "OskaBitState.hpp"
+#include "OskaPackedState.hpp"
+#include "Tablebase.hpp"
+#include "Playout.hpp"
 
-#define BIND( S ) case S: m_state_##S = new OskaStateTemplate<S> ( ); bind<S> ( m_state_##S ); break;
-#define BIND_COPY_FROM( S, OS ) case S: m_state_##S = new OskaStateTemplate<S> ( * OS.m_state_##S ); bind<S> ( m_state_##S ); break;
-#define BIND_MOVE_FROM( S, OS ) case S: std::swap ( m_no_stones, OS.m_no_stones ); std::swap ( m_state_##S, OS.m_state_##S ); bind<S> ( m_state_##S ); break;
-#define DESTROY( S ) case S: delete m_state_##S; break;
+
+#if 1
 
 namespace os {
 
     class OskaState {
 
-        // Dispatch class.
+        // Dispatch class, the board size is chosen once, in initialize ( no_stones_ ). Code that
+        // is hot (the search) should go through visit ( ), which is instantiated per board size.
 
     public:
 
-        using Move = Move;
-        template<std::size_t S>
-        using Moves = typename OskaStateTemplate<S>::Moves;
-        using Player = Player;
-
-        static constexpr index_t max_no_moves = 16;
+        using Move = ::Move;
+        using Player = ::Player;
+        using Variant = std::variant<OskaStateTemplate<4>, OskaStateTemplate<5>, OskaStateTemplate<6>, OskaStateTemplate<7>, OskaStateTemplate<8>>;
 
         index_t m_no_stones = 0;
 
-        OskaState ( ) noexcept {
-        }
-
     private:
 
-        OskaStateTemplate<4> * m_state_4 = nullptr;
-        OskaStateTemplate<5> * m_state_5 = nullptr;
-        OskaStateTemplate<6> * m_state_6 = nullptr;
-        OskaStateTemplate<7> * m_state_7 = nullptr;
-        OskaStateTemplate<8> * m_state_8 = nullptr;
-
-        function < void ( ) > m_initialize;
-        function < Location ( const Location & ) > m_other;
-        function < bool ( const std::int8_t ) > m_is_valid_id;
-        function < index_t ( const Point & ) > m_point_to_human_id;
-        function < index_t ( const Point & ) > m_point_to_hex_id;
-        function < Hexagon & ( const index_t ) > m_get_hex_ref_from_id;
-        function < index_t ( const Location & ) > m_get_id_from_location;
-        function < StoneID & ( ) > m_get_agent_stone_id;
-        function < StoneID & ( ) > m_get_human_stone_id;
-        function < Move const ( const index_t, const index_t ) > m_human_move;
-        function < Move ( ) > m_last_move;
-        function < ZobristHash ( ) > m_zobrist;
-        function < Player ( ) > m_player_to_move;
-        function < bool ( void * ) > m_moves;
-        function < void ( const Move & ) > m_move_hash;
-        function < void ( const Move & ) > m_move_hash_winner;
-        function < void ( ) > m_simulate;
-        function < float ( const Player ) > m_result;
-        function < std::optional<Player> ( ) > m_ended;
-        function < void ( ) > m_print;
-        function < Move const ( const Move & ) > m_do_move;
-        function < Move const ( ) > m_random_move;
-
-        template<index_t S>
-        void bind ( OskaStateTemplate<S> * m_state_ ) {
-
-            m_initialize = std::bind ( &OskaStateTemplate<S>::initialize, m_state_ );
-            m_other = std::bind ( &OskaStateTemplate<S>::other, m_state_, _1 );
-            m_is_valid_id = std::bind ( &OskaStateTemplate<S>::isValidID, m_state_, _1 );
-            m_point_to_human_id = std::bind ( &OskaStateTemplate<S>::pointToHumanID, m_state_, _1 );
-            m_point_to_hex_id = std::bind ( &OskaStateTemplate<S>::pointToHexID, m_state_, _1 );
-            m_get_hex_ref_from_id = std::bind ( &OskaStateTemplate<S>::getHexRefFromID, m_state_, _1 );
-            m_get_id_from_location = std::bind ( &OskaStateTemplate<S>::getIdFromLocation, m_state_, _1 );
-            m_get_agent_stone_id = std::bind ( &OskaStateTemplate<S>::getAgentStoneIDs, m_state_ );
-            m_get_human_stone_id = std::bind ( &OskaStateTemplate<S>::getHumanStoneIDs, m_state_ );
-            m_human_move = std::bind ( &OskaStateTemplate<S>::humanMove, m_state_, _1, _2 );
-            m_last_move = std::bind ( &OskaStateTemplate<S>::lastMove, m_state_ );
-            m_zobrist = std::bind ( &OskaStateTemplate<S>::zobrist, m_state_ );
-            m_player_to_move = std::bind ( &OskaStateTemplate<S>::playerToMove, m_state_ );
-            m_moves = ( bool ( * ) ( void * ) ) std::bind ( &OskaStateTemplate<S>::moves, m_state_, _1 );
-            m_move_hash = std::bind ( &OskaStateTemplate<S>::move_hash, m_state_, _1 );
-            m_move_hash_winner = std::bind ( &OskaStateTemplate<S>::move_hash_winner, m_state_, _1 );
-            m_simulate = std::bind ( &OskaStateTemplate<S>::simulate, m_state_ );
-            m_result = std::bind ( &OskaStateTemplate<S>::result, m_state_, _1 );
-            m_ended = std::bind ( &OskaStateTemplate<S>::ended, m_state_ );
-            m_print = std::bind ( &OskaStateTemplate<S>::print, m_state_ );
-            m_do_move = std::bind ( &OskaStateTemplate<S>::doMove, m_state_, _1 );
-            m_random_move = std::bind ( &OskaStateTemplate<S>::randomMove, m_state_ );
-        }
-
-        void destroy ( ) noexcept {
-            switch ( m_no_stones ) {
-                DESTROY ( 4 );
-                DESTROY ( 5 );
-                DESTROY ( 6 );
-                DESTROY ( 7 );
-                DESTROY ( 8 );
-                NO_DEFAULT_CASE;
-            }
-        }
+        Variant m_state;
 
     public:
 
-        OskaState ( const OskaState & s_ ) noexcept {
-            m_no_stones = s_.m_no_stones;
-            switch ( m_no_stones ) {
-                BIND_COPY_FROM ( 4, s_ );
-                BIND_COPY_FROM ( 5, s_ );
-                BIND_COPY_FROM ( 6, s_ );
-                BIND_COPY_FROM ( 7, s_ );
-                BIND_COPY_FROM ( 8, s_ );
-                NO_DEFAULT_CASE;
-            }
+        OskaState ( ) noexcept {
         }
 
-        OskaState ( OskaState && s_ ) noexcept {
-            assert ( m_no_stones == s_.m_no_stones );
+        void initialize ( const index_t no_stones_ ) {
+            m_no_stones = no_stones_;
             switch ( m_no_stones ) {
-                BIND_MOVE_FROM ( 4, s_ );
-                BIND_MOVE_FROM ( 5, s_ );
-                BIND_MOVE_FROM ( 6, s_ );
-                BIND_MOVE_FROM ( 7, s_ );
-                BIND_MOVE_FROM ( 8, s_ );
+                case 4: m_state.emplace<OskaStateTemplate<4>> ( ); break;
+                case 5: m_state.emplace<OskaStateTemplate<5>> ( ); break;
+                case 6: m_state.emplace<OskaStateTemplate<6>> ( ); break;
+                case 7: m_state.emplace<OskaStateTemplate<7>> ( ); break;
+                case 8: m_state.emplace<OskaStateTemplate<8>> ( ); break;
                 NO_DEFAULT_CASE;
             }
+            initialize ( );
         }
 
-        ~OskaState ( ) noexcept {
-            destroy ( );
+        template<typename Visitor>
+        decltype ( auto ) visit ( Visitor && visitor_ ) {
+            return std::visit ( std::forward<Visitor> ( visitor_ ), m_state );
         }
 
-        void initialize ( const index_t no_stones_ ) {
-            destroy ( );
-            m_no_stones = no_stones_;
-            switch ( m_no_stones ) {
-                BIND ( 4 );
-                BIND ( 5 );
-                BIND ( 6 );
-                BIND ( 7 );
-                BIND ( 8 );
-                NO_DEFAULT_CASE;
-            }
-            m_initialize ( );
+        template<typename Visitor>
+        decltype ( auto ) visit ( Visitor && visitor_ ) const {
+            return std::visit ( std::forward<Visitor> ( visitor_ ), m_state );
         }
 
-        void initialize ( ) const noexcept { m_initialize ( ); }
-        [[ nodiscard ]] Location other ( const Location & l_ ) const noexcept { return m_other ( l_ ); }
-        [[ nodiscard ]] bool isValidID ( const std::int8_t id_ ) const noexcept { return m_is_valid_id ( id_ ); }
-        [[ nodiscard ]] index_t pointToHumanID ( const Point & p_ ) const noexcept { return m_point_to_human_id ( p_ ); }
-        [[ nodiscard ]] index_t pointToHexID ( const  Point & p_ ) const noexcept { return m_point_to_hex_id ( p_ ); }
-        [[ nodiscard ]] Hexagon & getHexRefFromID ( const index_t i_ ) noexcept { return m_get_hex_ref_from_id ( i_ ); }
-        [[ nodiscard ]] index_t getIdFromLocation ( const Location & l_ ) const noexcept { return m_get_id_from_location ( l_ ); }
-        [[ nodiscard ]] StoneID & getAgentStoneIDs ( ) noexcept { return m_get_agent_stone_id ( ); }
-        [[ nodiscard ]] StoneID & getHumanStoneIDs ( ) noexcept { return m_get_human_stone_id ( ); }
-        [[ nodiscard ]] Move const humanMove ( const index_t f_, const index_t t_ ) const noexcept { return m_human_move ( f_, t_ ); }
-        [[ nodiscard ]] Move lastMove ( ) const noexcept { return m_last_move ( ); }
-        [[ nodiscard ]] ZobristHash zobrist ( ) const noexcept { return m_zobrist ( ); }
-        [[ nodiscard ]] Player playerToMove ( ) const noexcept { return m_player_to_move ( ); }
-        [[ nodiscard ]] Player playerJustMoved ( ) const noexcept { return m_player_to_move ( ).opponent ( ); }
-        template<typename M>
-        [[ nodiscard ]] bool moves ( M * moves_ ) const noexcept { return m_moves ( moves_ ); }
-        void move_hash ( const Move & move_ ) noexcept { return m_move_hash ( move_ ); }
-        void move_hash_winner ( const Move & move_ ) noexcept { return m_move_hash_winner ( move_ ); }
-        void simulate ( ) noexcept { m_simulate ( ); }
-        [[ nodiscard ]] float result ( const Player player_ ) const noexcept { return m_result ( player_ ); }
-        [[ nodiscard ]] std::optional<Player> ended ( ) const noexcept { return m_ended ( ); }
-        void print ( ) const noexcept { return m_print ( ); }
-        [[ maybe_unused ]] Move const doMove ( const Move & move_ ) noexcept { return m_do_move ( move_ ); }
-        [[ nodiscard ]] Move const randomMove ( ) noexcept { return m_random_move ( ); }
+        void initialize ( ) { visit ( [ ] ( auto & s_ ) { s_.initialize ( ); } ); }
+        [[ nodiscard ]] Location other ( const Location & l_ ) const noexcept { return visit ( [ & ] ( const auto & s_ ) { return s_.other ( l_ ); } ); }
+        [[ nodiscard ]] bool isValidID ( const std::int8_t id_ ) const noexcept { return visit ( [ = ] ( const auto & s_ ) { return s_.isValidID ( id_ ); } ); }
+#if not defined ( OSKA_HEADLESS )
+        [[ nodiscard ]] index_t pointToHumanID ( const Point & p_ ) const noexcept { return visit ( [ & ] ( const auto & s_ ) { return s_.pointToHumanID ( p_ ); } ); }
+        [[ nodiscard ]] index_t pointToHexID ( const  Point & p_ ) const noexcept { return visit ( [ & ] ( const auto & s_ ) { return s_.pointToHexID ( p_ ); } ); }
+        [[ nodiscard ]] Hexagon & getHexRefFromID ( const index_t i_ ) noexcept { return visit ( [ = ] ( auto & s_ ) -> Hexagon & { return s_.getHexRefFromID ( i_ ); } ); }
+#endif
+        [[ nodiscard ]] index_t getIdFromLocation ( const Location & l_ ) const noexcept { return visit ( [ & ] ( const auto & s_ ) { return s_.getIdFromLocation ( l_ ); } ); }
+        [[ nodiscard ]] StoneID & getAgentStoneIDs ( ) noexcept { return visit ( [ ] ( auto & s_ ) -> StoneID & { return s_.getAgentStoneIDs ( ); } ); }
+        [[ nodiscard ]] StoneID & getHumanStoneIDs ( ) noexcept { return visit ( [ ] ( auto & s_ ) -> StoneID & { return s_.getHumanStoneIDs ( ); } ); }
+        [[ nodiscard ]] Move const humanMove ( const index_t f_, const index_t t_ ) const noexcept { return visit ( [ = ] ( const auto & s_ ) { return s_.humanMove ( f_, t_ ); } ); }
+        [[ nodiscard ]] Move lastMove ( ) const noexcept { return visit ( [ ] ( const auto & s_ ) { return s_.lastMove ( ); } ); }
+        [[ nodiscard ]] ZobristHash zobrist ( ) const noexcept { return visit ( [ ] ( const auto & s_ ) { return s_.zobrist ( ); } ); }
+        [[ nodiscard ]] Player playerToMove ( ) const noexcept { return visit ( [ ] ( const auto & s_ ) { return s_.playerToMove ( ); } ); }
+        [[ nodiscard ]] Player playerJustMoved ( ) const noexcept { return visit ( [ ] ( const auto & s_ ) { return s_.playerJustMoved ( ); } ); }
+        [[ nodiscard ]] std::optional<Player> ended ( ) const noexcept { return visit ( [ ] ( const auto & s_ ) { return s_.ended ( ); } ); }
+        void print ( ) const noexcept { visit ( [ ] ( const auto & s_ ) { s_.print ( ); } ); }
+        [[ maybe_unused ]] Move const doMove ( const Move & move_ ) noexcept { return visit ( [ & ] ( auto & s_ ) { return s_.doMove ( move_ ); } ); }
+        [[ nodiscard ]] Move const randomMove ( ) const noexcept { return visit ( [ ] ( const auto & s_ ) { return s_.randomMove ( ); } ); }
     };
 }
 
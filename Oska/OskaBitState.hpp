@@ -0,0 +1,871 @@
+
+// MIT License
+//
+// Copyright (c) 2018 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+
+#include <algorithm>
+#include <array>
+#include <iostream>
+#include <random>
+#include <type_traits>
+
+#if defined ( _MSC_VER ) and not defined ( __clang__ )
+#include <intrin.h>
+#elif defined ( __AVX2__ ) or defined ( __BMI2__ )
+#include <immintrin.h>
+#endif
+
+#include "multi_array.hpp"
+
+#include "Typedefs.hpp"
+#include "Globals.hpp"
+#include "player.hpp"
+#include "moves.hpp"
+#include "Oska.hpp"
+
+
+// Bitboard representation of an Oska position.
+//
+// The hexagons are mapped onto the bits of a single word, in skewed coordinates
+// x = ( c + r ) / 2 and y = ( r - c ) / 2 (agent's perspective), as bit = ( x + stride * y )
+// mod width. A left step ( c + 1, r + 1 ) is then a rotation by 1 and a right step
+// ( c - 1, r + 1 ) a rotation by stride, so that the moves and captures of all stones of
+// a player are found with a handful of rotations and ANDs. The stride is the smallest
+// one that maps the hexagons of board size S onto distinct bits. Boards up to S = 7 (52
+// hexagons) fit a 64-bit word, S = 8 has 68 hexagons and uses a 128-bit word.
+
+namespace bb {
+
+    struct uint128 { // 16
+
+        std::uint64_t lo = 0, hi = 0;
+
+        constexpr uint128 ( ) noexcept { }
+        constexpr uint128 ( const std::uint64_t lo_, const std::uint64_t hi_ = 0 ) noexcept : lo ( lo_ ), hi ( hi_ ) { }
+
+        [[ nodiscard ]] constexpr uint128 operator & ( const uint128 & rhs_ ) const noexcept { return uint128 ( lo & rhs_.lo, hi & rhs_.hi ); }
+        [[ nodiscard ]] constexpr uint128 operator | ( const uint128 & rhs_ ) const noexcept { return uint128 ( lo | rhs_.lo, hi | rhs_.hi ); }
+        [[ nodiscard ]] constexpr uint128 operator ^ ( const uint128 & rhs_ ) const noexcept { return uint128 ( lo ^ rhs_.lo, hi ^ rhs_.hi ); }
+        [[ nodiscard ]] constexpr uint128 operator ~ ( ) const noexcept { return uint128 ( ~lo, ~hi ); }
+
+        constexpr uint128 & operator &= ( const uint128 & rhs_ ) noexcept { lo &= rhs_.lo; hi &= rhs_.hi; return * this; }
+        constexpr uint128 & operator |= ( const uint128 & rhs_ ) noexcept { lo |= rhs_.lo; hi |= rhs_.hi; return * this; }
+        constexpr uint128 & operator ^= ( const uint128 & rhs_ ) noexcept { lo ^= rhs_.lo; hi ^= rhs_.hi; return * this; }
+
+        [[ nodiscard ]] constexpr bool operator == ( const uint128 & rhs_ ) const noexcept { return lo == rhs_.lo and hi == rhs_.hi; }
+        [[ nodiscard ]] constexpr bool operator != ( const uint128 & rhs_ ) const noexcept { return lo != rhs_.lo or hi != rhs_.hi; }
+
+        [[ nodiscard ]] constexpr explicit operator bool ( ) const noexcept { return lo | hi; }
+    };
+
+
+    template<typename Bitboard>
+    constexpr index_t width = 8 * sizeof ( Bitboard );
+
+
+    template<typename Bitboard>
+    [[ nodiscard ]] constexpr Bitboard bit ( const index_t i_ ) noexcept;
+
+    template<>
+    [[ nodiscard ]] constexpr std::uint64_t bit<std::uint64_t> ( const index_t i_ ) noexcept {
+        return std::uint64_t { 1 } << i_;
+    }
+
+    template<>
+    [[ nodiscard ]] constexpr uint128 bit<uint128> ( const index_t i_ ) noexcept {
+        return i_ < 64 ? uint128 ( std::uint64_t { 1 } << i_, 0 ) : uint128 ( 0, std::uint64_t { 1 } << ( i_ - 64 ) );
+    }
+
+
+    // Rotate left, 0 < n_ < width.
+
+    [[ nodiscard ]] constexpr std::uint64_t rotl ( const std::uint64_t b_, const index_t n_ ) noexcept {
+        return ( b_ << n_ ) | ( b_ >> ( 64 - n_ ) );
+    }
+
+    [[ nodiscard ]] constexpr uint128 rotl ( const uint128 & b_, const index_t n_ ) noexcept {
+        if ( n_ == 64 ) {
+            return uint128 ( b_.hi, b_.lo );
+        }
+        const uint128 b = n_ < 64 ? b_ : uint128 ( b_.hi, b_.lo ); // Rotation by 64 swaps the halves.
+        const index_t n = n_ & 63;
+        return uint128 ( ( b.lo << n ) | ( b.hi >> ( 64 - n ) ), ( b.hi << n ) | ( b.lo >> ( 64 - n ) ) );
+    }
+
+
+    [[ nodiscard ]] inline index_t popcount ( const std::uint64_t b_ ) noexcept {
+#if defined ( _MSC_VER ) and not defined ( __clang__ )
+        return ( index_t ) __popcnt64 ( b_ );
+#else
+        return __builtin_popcountll ( b_ );
+#endif
+    }
+
+    [[ nodiscard ]] inline index_t popcount ( const uint128 & b_ ) noexcept {
+        return popcount ( b_.lo ) + popcount ( b_.hi );
+    }
+
+
+    // Index of the least significant set bit, b_ not 0.
+
+    [[ nodiscard ]] inline index_t lsb ( const std::uint64_t b_ ) noexcept {
+#if defined ( _MSC_VER ) and not defined ( __clang__ )
+        unsigned long i;
+        _BitScanForward64 ( & i, b_ );
+        return ( index_t ) i;
+#else
+        return __builtin_ctzll ( b_ );
+#endif
+    }
+
+    [[ nodiscard ]] inline index_t lsb ( const uint128 & b_ ) noexcept {
+        return b_.lo ? lsb ( b_.lo ) : 64 + lsb ( b_.hi );
+    }
+
+
+    // Clear the least significant set bit.
+
+    [[ nodiscard ]] constexpr std::uint64_t reset_lsb ( const std::uint64_t b_ ) noexcept {
+        return b_ & ( b_ - 1 );
+    }
+
+    [[ nodiscard ]] constexpr uint128 reset_lsb ( const uint128 & b_ ) noexcept {
+        return b_.lo ? uint128 ( b_.lo & ( b_.lo - 1 ), b_.hi ) : uint128 ( 0, b_.hi & ( b_.hi - 1 ) );
+    }
+
+
+    template<index_t S>
+    struct Geometry {
+
+        static constexpr index_t no_hexagons = NO_HEXAGONS ( S ), no_cols = OB_COLS ( S ), no_rows = OB_ROWS ( S );
+
+        using Bitboard = std::conditional_t<( no_hexagons <= 64 ), std::uint64_t, uint128>;
+
+        static constexpr index_t no_bits = width<Bitboard>;
+
+        using Cell = typename HexagonGeometry<S>::Cell;
+
+        enum Direction : index_t { StepLeft = 0, StepRight, JumpLeft, JumpRight };
+
+    private:
+
+        using Hexagons = std::array<Cell, no_hexagons>;
+
+        [[ nodiscard ]] static constexpr Hexagons hexagons ( ) noexcept {
+            Hexagons h { };
+            for ( index_t id = 0; id < no_hexagons; ++id ) {
+                h [ id ] = HexagonGeometry<S>::tables.cell [ id ];
+            }
+            return h;
+        }
+
+        [[ nodiscard ]] static constexpr index_t index ( const index_t c_, const index_t r_, const index_t stride_ ) noexcept {
+            // Skewed coordinates, y is offset to keep it positive.
+            return ( ( c_ + r_ ) / 2 + stride_ * ( ( r_ - c_ ) / 2 + no_cols ) ) % no_bits;
+        }
+
+        [[ nodiscard ]] static constexpr index_t findStride ( ) noexcept {
+            const Hexagons h = hexagons ( );
+            for ( index_t stride = 2; stride < no_bits; ++stride ) {
+                std::array<bool, no_bits> taken { };
+                bool is_unique = true;
+                for ( const Cell & cell : h ) {
+                    bool & t = taken [ index ( cell.c, cell.r, stride ) ];
+                    is_unique = is_unique and not ( t );
+                    t = true;
+                }
+                if ( is_unique ) {
+                    return stride;
+                }
+            }
+            return 0;
+        }
+
+    public:
+
+        static constexpr index_t stride = findStride ( );
+
+        static_assert ( stride > 0, "no stride maps the board onto the bitboard" );
+
+        struct Tables {
+
+            std::array<Cell, no_bits> bit_to_cell { };                               // Agent's perspective, invalid for unused bits.
+            std::array<std::array<std::int8_t, no_rows>, no_cols> cell_to_bit { };  // Agent's perspective, -1 off-board.
+            std::array<std::int8_t, no_hexagons> id_to_bit { };
+            std::array<std::int8_t, no_bits> bit_to_id { };
+
+            Bitboard board { };
+            Bitboard home [ 2 ] { };                 // By Player::as_01index ( ), the far row of the player.
+            Bitboard source [ 2 ] [ 4 ] { };         // By player and Direction, the stones that have that step or jump on the board.
+            index_t shift [ 2 ] [ 4 ] { };           // By player and Direction, the rotation from source to target.
+            index_t back [ 2 ] [ 4 ] { };            // By player and Direction, the rotation from target to source.
+        };
+
+    private:
+
+        [[ nodiscard ]] static constexpr bool onBoard ( const Tables & t_, const index_t c_, const index_t r_ ) noexcept {
+            return c_ >= 0 and c_ < no_cols and r_ >= 0 and r_ < no_rows and t_.cell_to_bit [ c_ ] [ r_ ] >= 0;
+        }
+
+        [[ nodiscard ]] static constexpr Tables build ( ) noexcept {
+            Tables t;
+            for ( auto & column : t.cell_to_bit ) {
+                for ( auto & b : column ) {
+                    b = -1;
+                }
+            }
+            for ( auto & i : t.bit_to_id ) {
+                i = -1;
+            }
+            const Hexagons h = hexagons ( );
+            for ( index_t id = 0; id < no_hexagons; ++id ) {
+                const index_t b = index ( h [ id ].c, h [ id ].r, stride );
+                t.bit_to_cell [ b ] = h [ id ];
+                t.cell_to_bit [ h [ id ].c ] [ h [ id ].r ] = ( std::int8_t ) b;
+                t.id_to_bit [ id ] = ( std::int8_t ) b;
+                t.bit_to_id [ b ] = ( std::int8_t ) id;
+                t.board |= bit<Bitboard> ( b );
+                if ( h [ id ].r == 1 ) {
+                    t.home [ 1 ] |= bit<Bitboard> ( b );
+                }
+                if ( h [ id ].r == OB_HOME_ROW ( S ) ) {
+                    t.home [ 0 ] |= bit<Bitboard> ( b );
+                }
+            }
+            // The agent moves down the board, the human up, left and right from their own perspective.
+            const index_t dc [ 2 ] [ 2 ] = { { 1, -1 }, { -1, 1 } }, dr [ 2 ] = { 1, -1 };
+            const index_t step [ 2 ] = { 1, stride };
+            for ( index_t p = 0; p < 2; ++p ) {
+                for ( index_t d = 0; d < 2; ++d ) {
+                    const index_t s = p ? no_bits - step [ d ] : step [ d ], j = ( 2 * s ) % no_bits;
+                    t.shift [ p ] [ StepLeft + d ] = s, t.back [ p ] [ StepLeft + d ] = no_bits - s;
+                    t.shift [ p ] [ JumpLeft + d ] = j, t.back [ p ] [ JumpLeft + d ] = no_bits - j;
+                    for ( const Cell & cell : h ) {
+                        const Bitboard b = bit<Bitboard> ( t.cell_to_bit [ cell.c ] [ cell.r ] );
+                        if ( onBoard ( t, cell.c + dc [ p ] [ d ], cell.r + dr [ p ] ) ) {
+                            t.source [ p ] [ StepLeft + d ] |= b;
+                        }
+                        if ( onBoard ( t, cell.c + 2 * dc [ p ] [ d ], cell.r + 2 * dr [ p ] ) ) {
+                            t.source [ p ] [ JumpLeft + d ] |= b;
+                        }
+                    }
+                }
+            }
+            return t;
+        }
+
+    public:
+
+        static constexpr Tables tables = build ( );
+    };
+
+
+    // The Zobrist keys of OskaStateTemplate<S>, re-indexed by bit (the human's keyed in human's
+    // perspective, as there), so that both states hash a position the same.
+
+    template<index_t S>
+    struct ZobristKeys {
+
+        using Geometry = bb::Geometry<S>;
+
+        struct Table {
+
+            ZobristHash key [ 2 ] [ Geometry::no_bits ];
+
+            [[ nodiscard ]] constexpr ZobristHash at ( const index_t p_, const index_t b_ ) const noexcept {
+                return key [ p_ ] [ b_ ];
+            }
+        };
+
+    private:
+
+        [[ nodiscard ]] static constexpr Table build ( ) noexcept {
+            Table t { };
+            for ( index_t b = 0; b < Geometry::no_bits; ++b ) {
+                if ( Geometry::tables.bit_to_id [ b ] >= 0 ) {
+                    const typename Geometry::Cell cell = Geometry::tables.bit_to_cell [ b ];
+                    t.key [ 0 ] [ b ] = ::ZobristKeys<S>::table.at ( 0, cell.c, cell.r );
+                    t.key [ 1 ] [ b ] = ::ZobristKeys<S>::table.at ( 1, ( OB_COLS ( S ) - 1 ) - cell.c, ( OB_ROWS ( S ) - 1 ) - cell.r );
+                }
+            }
+            return t;
+        }
+
+    public:
+
+        static constexpr Table table = build ( );
+    };
+
+
+    // The stones of either player as bitboards, kept up to date by OskaStateTemplate<S> next to
+    // its boards (a move flips two or three bits), whether a player can move at all is then a
+    // handful of rotates and masks, instead of trying the moves of the stones one by one.
+
+    template<index_t S>
+    class Mobility {
+
+        using Geometry = bb::Geometry<S>;
+        using Bitboard = typename Geometry::Bitboard;
+
+        static constexpr const typename Geometry::Tables & g = Geometry::tables;
+
+        Bitboard m_stones [ 2 ] { }; // By Player::as_01index ( ), both in agent's perspective.
+
+    public:
+
+        void clear ( ) noexcept {
+            m_stones [ 0 ] = m_stones [ 1 ] = Bitboard { };
+        }
+
+        void flip ( const index_t p_, const index_t id_ ) noexcept {
+            // Place, or remove, the stone of p_ at (agent's) hexagon-id id_.
+            m_stones [ p_ ] ^= bit<Bitboard> ( g.id_to_bit [ id_ ] );
+        }
+
+        void move ( const index_t p_, const index_t from_, const index_t to_ ) noexcept {
+            m_stones [ p_ ] ^= bit<Bitboard> ( g.id_to_bit [ from_ ] ) | bit<Bitboard> ( g.id_to_bit [ to_ ] );
+        }
+
+        [[ nodiscard ]] bool hasMoves ( const index_t p_ ) const noexcept {
+            return hasMoves ( m_stones [ p_ ], m_stones [ p_ ^ 1 ], p_ );
+        }
+
+        [[ nodiscard ]] static bool hasMoves ( const Bitboard mine_, const Bitboard theirs_, const index_t p_ ) noexcept {
+            const Bitboard vacant = g.board & ~( mine_ | theirs_ );
+            const Bitboard steps = ( g.source [ p_ ] [ Geometry::StepLeft ] & rotl ( vacant, g.back [ p_ ] [ Geometry::StepLeft ] ) )
+                                 | ( g.source [ p_ ] [ Geometry::StepRight ] & rotl ( vacant, g.back [ p_ ] [ Geometry::StepRight ] ) );
+            const Bitboard jumps = ( g.source [ p_ ] [ Geometry::JumpLeft ] & rotl ( theirs_, g.back [ p_ ] [ Geometry::StepLeft ] ) & rotl ( vacant, g.back [ p_ ] [ Geometry::JumpLeft ] ) )
+                                 | ( g.source [ p_ ] [ Geometry::JumpRight ] & rotl ( theirs_, g.back [ p_ ] [ Geometry::StepRight ] ) & rotl ( vacant, g.back [ p_ ] [ Geometry::JumpRight ] ) );
+            return ( mine_ & ( steps | jumps ) ) != Bitboard { };
+        }
+    };
+
+
+    // Index of the n_-th (from 0) set bit of b_, b_ has more than n_ bits set.
+
+    [[ nodiscard ]] inline index_t select ( std::uint64_t b_, index_t n_ ) noexcept {
+#if defined ( __BMI2__ )
+        return lsb ( _pdep_u64 ( std::uint64_t { 1 } << n_, b_ ) );
+#else
+        for ( ; n_; --n_ ) {
+            b_ = reset_lsb ( b_ );
+        }
+        return lsb ( b_ );
+#endif
+    }
+
+
+    // Random play-outs of N games in lock-step, all starting from the same position, so
+    // the side to move is the same in all games. The positions are kept as structure of
+    // arrays, a lane per game, and the move generation of all lanes (the rotations and
+    // masks) runs in AVX2 registers, or in whatever the compiler makes of the plain loop
+    // (SSE2 at least) otherwise. Picking and making the moves is done per lane.
+
+    template<index_t S, index_t N>
+    class BatchPlayout {
+
+        using Geometry = bb::Geometry<S>;
+
+        static_assert ( std::is_same_v<typename Geometry::Bitboard, std::uint64_t>, "BatchPlayout requires a 64-bit bitboard" );
+
+        static constexpr index_t L = ( N + 3 ) & ~3; // Lanes, a multiple of the 4 lanes of an AVX2 register.
+
+        static constexpr const typename Geometry::Tables & g = Geometry::tables;
+
+        alignas ( 32 ) std::uint64_t m_stones [ 2 ] [ L ];   // By Player::as_01index ( ) and lane.
+        alignas ( 32 ) std::uint64_t m_sources [ 4 ] [ L ];  // By Geometry::Direction and lane.
+        alignas ( 32 ) std::uint64_t m_active [ L ];         // All bits set for a game in progress.
+
+#if defined ( __AVX2__ )
+        [[ nodiscard ]] static __m256i rotl ( const __m256i b_, const index_t n_ ) noexcept {
+            return _mm256_or_si256 ( _mm256_sll_epi64 ( b_, _mm_cvtsi32_si128 ( n_ ) ), _mm256_srl_epi64 ( b_, _mm_cvtsi32_si128 ( 64 - n_ ) ) );
+        }
+#endif
+
+        void sources ( const index_t p_ ) noexcept {
+            const index_t sl = g.back [ p_ ] [ Geometry::StepLeft ], sr = g.back [ p_ ] [ Geometry::StepRight ];
+            const index_t jl = g.back [ p_ ] [ Geometry::JumpLeft ], jr = g.back [ p_ ] [ Geometry::JumpRight ];
+#if defined ( __AVX2__ )
+            const __m256i board = _mm256_set1_epi64x ( ( long long ) g.board );
+            const __m256i src_sl = _mm256_set1_epi64x ( ( long long ) g.source [ p_ ] [ Geometry::StepLeft ] ), src_sr = _mm256_set1_epi64x ( ( long long ) g.source [ p_ ] [ Geometry::StepRight ] );
+            const __m256i src_jl = _mm256_set1_epi64x ( ( long long ) g.source [ p_ ] [ Geometry::JumpLeft ] ), src_jr = _mm256_set1_epi64x ( ( long long ) g.source [ p_ ] [ Geometry::JumpRight ] );
+            for ( index_t l = 0; l < L; l += 4 ) {
+                const __m256i mine = _mm256_load_si256 ( ( const __m256i * ) ( m_stones [ p_ ] + l ) ), theirs = _mm256_load_si256 ( ( const __m256i * ) ( m_stones [ p_ ^ 1 ] + l ) );
+                const __m256i movers = _mm256_and_si256 ( mine, _mm256_load_si256 ( ( const __m256i * ) ( m_active + l ) ) );
+                const __m256i vacant = _mm256_andnot_si256 ( _mm256_or_si256 ( mine, theirs ), board );
+                _mm256_store_si256 ( ( __m256i * ) ( m_sources [ Geometry::StepLeft ] + l ), _mm256_and_si256 ( _mm256_and_si256 ( movers, src_sl ), rotl ( vacant, sl ) ) );
+                _mm256_store_si256 ( ( __m256i * ) ( m_sources [ Geometry::StepRight ] + l ), _mm256_and_si256 ( _mm256_and_si256 ( movers, src_sr ), rotl ( vacant, sr ) ) );
+                _mm256_store_si256 ( ( __m256i * ) ( m_sources [ Geometry::JumpLeft ] + l ), _mm256_and_si256 ( _mm256_and_si256 ( movers, src_jl ), _mm256_and_si256 ( rotl ( theirs, sl ), rotl ( vacant, jl ) ) ) );
+                _mm256_store_si256 ( ( __m256i * ) ( m_sources [ Geometry::JumpRight ] + l ), _mm256_and_si256 ( _mm256_and_si256 ( movers, src_jr ), _mm256_and_si256 ( rotl ( theirs, sr ), rotl ( vacant, jr ) ) ) );
+            }
+#else
+            for ( index_t l = 0; l < L; ++l ) {
+                const std::uint64_t mine = m_stones [ p_ ] [ l ], theirs = m_stones [ p_ ^ 1 ] [ l ], movers = mine & m_active [ l ], vacant = g.board & ~( mine | theirs );
+                m_sources [ Geometry::StepLeft ] [ l ] = movers & g.source [ p_ ] [ Geometry::StepLeft ] & rotl ( vacant, sl );
+                m_sources [ Geometry::StepRight ] [ l ] = movers & g.source [ p_ ] [ Geometry::StepRight ] & rotl ( vacant, sr );
+                m_sources [ Geometry::JumpLeft ] [ l ] = movers & g.source [ p_ ] [ Geometry::JumpLeft ] & rotl ( theirs, sl ) & rotl ( vacant, jl );
+                m_sources [ Geometry::JumpRight ] [ l ] = movers & g.source [ p_ ] [ Geometry::JumpRight ] & rotl ( theirs, sr ) & rotl ( vacant, jr );
+            }
+#endif
+        }
+
+    public:
+
+        // Play out the position, stones_ by Player::as_01index ( ), with p_ (as 01-index) to move,
+        // the winners are written to winners_.
+
+        void run ( const std::uint64_t ( & stones_ ) [ 2 ], index_t p_, Player ( & winners_ ) [ N ] ) noexcept {
+            for ( index_t l = 0; l < L; ++l ) {
+                m_stones [ 0 ] [ l ] = stones_ [ 0 ];
+                m_stones [ 1 ] [ l ] = stones_ [ 1 ];
+                m_active [ l ] = l < N ? ~std::uint64_t { 0 } : std::uint64_t { 0 };
+            }
+            rng_t rng ( g_rng ( ) );
+            for ( index_t no_active = N; no_active; p_ ^= 1 ) {
+                sources ( p_ );
+                const Player player = p_ ? Player::Type::human : Player::Type::agent;
+                for ( index_t l = 0; l < N; ++l ) {
+                    if ( not ( m_active [ l ] ) ) {
+                        continue;
+                    }
+                    index_t n [ 4 ], no_moves = 0;
+                    for ( index_t d = Geometry::StepLeft; d <= Geometry::JumpRight; ++d ) {
+                        no_moves += n [ d ] = popcount ( m_sources [ d ] [ l ] );
+                    }
+                    if ( not ( no_moves ) ) { // The player that cannot move wins.
+                        winners_ [ l ] = player;
+                        m_active [ l ] = 0, --no_active;
+                        continue;
+                    }
+                    index_t i = ( index_t ) ( ( ( rng ( ) >> 32 ) * ( std::uint64_t ) no_moves ) >> 32 ), d = Geometry::StepLeft;
+                    for ( ; i >= n [ d ]; ++d ) {
+                        i -= n [ d ];
+                    }
+                    const index_t f = select ( m_sources [ d ] [ l ], i );
+                    m_stones [ p_ ] [ l ] ^= bit<std::uint64_t> ( f ) | bit<std::uint64_t> ( ( f + g.shift [ p_ ] [ d ] ) % 64 );
+                    if ( d >= Geometry::JumpLeft ) {
+                        m_stones [ p_ ^ 1 ] [ l ] ^= bit<std::uint64_t> ( ( f + g.shift [ p_ ] [ d - 2 ] ) % 64 );
+                    }
+                    // As OskaBitStateTemplate<S>::winner ( ), the no moves case is dealt with above, in the next ply.
+                    if ( not ( m_stones [ p_ ] [ l ] & ~g.home [ p_ ] ) ) {
+                        const std::uint64_t other = m_stones [ p_ ^ 1 ] [ l ];
+                        if ( other and not ( other & ~g.home [ p_ ^ 1 ] ) ) {
+                            const index_t home = popcount ( m_stones [ p_ ] [ l ] & g.home [ p_ ] ), other_home = popcount ( other & g.home [ p_ ^ 1 ] );
+                            winners_ [ l ] = home == other_home ? Player ( Player::Type::vacant ) : ( ( home > other_home ) == ( p_ == 0 ) ? Player ( Player::Type::agent ) : Player ( Player::Type::human ) );
+                        }
+                        else {
+                            winners_ [ l ] = player;
+                        }
+                        m_active [ l ] = 0, --no_active;
+                    }
+                    else if ( not ( m_stones [ p_ ^ 1 ] [ l ] ) ) {
+                        winners_ [ l ] = player;
+                        m_active [ l ] = 0, --no_active;
+                    }
+                }
+            }
+        }
+    };
+}
+
+
+namespace tb {
+    template<index_t S>
+    class Tablebase;
+}
+
+namespace po {
+    struct Uniform;
+}
+
+
+template<index_t S>
+class OskaBitStateTemplate {
+
+    friend class OskaPackedStateTemplate<S>;
+    friend class tb::Tablebase<S>;
+
+public:
+
+    static constexpr index_t max_no_moves = 2 * S;
+
+    using Player = ::Player;
+    using ZobristHash = ::ZobristHash;
+    using Move = ::Move;
+    using Moves = ::Moves<Move, max_no_moves>;
+    using CompactMove = ::CompactMove;
+    using CompactMoves = ::Moves<CompactMove, max_no_moves>;
+
+    using Geometry = bb::Geometry<S>;
+    using Bitboard = typename Geometry::Bitboard;
+
+    using BitState = OskaBitStateTemplate;
+    using PlayoutPolicy = po::Uniform;
+
+    struct Sources { // The stones that can move, by Geometry::Direction.
+        Bitboard m_stones [ 4 ];
+    };
+
+    struct BitMove { // The stone at bit f going in Geometry::Direction d, as picked by a play-out policy.
+        index_t d, f;
+    };
+
+private:
+
+    static constexpr const typename Geometry::Tables & g = Geometry::tables;
+
+    Bitboard m_stones [ 2 ] { }; // By Player::as_01index ( ), both in agent's perspective.
+
+    ZobristHash m_zobrist_hash = 0;
+
+    Player m_player_to_move = Player::Type::agent, m_winner = Player::Type::invalid;
+
+    Move m_last_move = Move::root;
+
+    static constexpr const typename bb::ZobristKeys<S>::Table & m_zobrist_keys = bb::ZobristKeys<S>::table;
+
+public:
+
+    OskaBitStateTemplate ( ) noexcept {
+    }
+
+    explicit OskaBitStateTemplate ( const OskaStateTemplate<S> & s_ ) noexcept {
+        for ( const index_t id : s_.m_agent_stone_id ) {
+            m_stones [ 0 ] |= bb::bit<Bitboard> ( g.id_to_bit [ id ] );
+        }
+        for ( const index_t id : s_.m_human_stone_id ) {
+            m_stones [ 1 ] |= bb::bit<Bitboard> ( g.id_to_bit [ id ] );
+        }
+        m_zobrist_hash = hash ( );
+        m_player_to_move = s_.m_player_to_move;
+        m_winner = s_.m_winner;
+        m_last_move = s_.m_last_move;
+    }
+
+    void initialize ( ) noexcept {
+        m_stones [ 0 ] = g.home [ 1 ]; // The agent starts on the far row of the human and v.v.
+        m_stones [ 1 ] = g.home [ 0 ];
+        m_zobrist_hash = hash ( );
+        m_player_to_move = Player::random ( );
+        m_winner = Player::Type::invalid;
+        m_last_move = Move::root;
+    }
+
+    [[ nodiscard ]] static CompactMove compact ( const Move & m_ ) noexcept {
+        return HexagonGeometry<S>::compact ( m_ );
+    }
+
+    [[ nodiscard ]] static Move expand ( const CompactMove m_ ) noexcept {
+        return HexagonGeometry<S>::expand ( m_ );
+    }
+
+    [[ nodiscard ]] ZobristHash zobrist ( ) const noexcept {
+        return m_zobrist_hash ^ OskaStateTemplate<S>::m_zobrist_player_keys [ m_player_to_move.as_index ( ) ];
+    }
+
+    [[ nodiscard ]] Player playerToMove ( ) const noexcept {
+        return m_player_to_move;
+    }
+
+    [[ nodiscard ]] Player playerJustMoved ( ) const noexcept {
+        return m_player_to_move.opponent ( );
+    }
+
+    [[ nodiscard ]] Bitboard stones ( const Player player_ ) const noexcept {
+        return m_stones [ index ( player_ ) ];
+    }
+
+    [[ nodiscard ]] index_t noStones ( const Player player_ ) const noexcept {
+        return bb::popcount ( m_stones [ index ( player_ ) ] );
+    }
+
+    [[ nodiscard ]] index_t noHome ( const Player player_ ) const noexcept {
+        const index_t p = index ( player_ );
+        return bb::popcount ( m_stones [ p ] & g.home [ p ] );
+    }
+
+    [[ nodiscard ]] bool haveRemainingHome ( const Player player_ ) const noexcept {
+        // All remaining stones (and at least one) are home.
+        const index_t p = index ( player_ );
+        return m_stones [ p ] and not ( m_stones [ p ] & ~g.home [ p ] );
+    }
+
+    [[ nodiscard ]] bool notHaveStones ( const Player player_ ) const noexcept {
+        return not ( m_stones [ index ( player_ ) ] );
+    }
+
+    [[ nodiscard ]] Player playerMostHomeStones ( ) const noexcept {
+        const index_t no_home_agent = noHome ( Player::Type::agent ), no_home_human = noHome ( Player::Type::human );
+        if ( no_home_agent > no_home_human ) return Player::Type::agent;
+        if ( no_home_agent < no_home_human ) return Player::Type::human;
+        return Player::Type::vacant;
+    }
+
+private:
+
+    [[ nodiscard ]] static index_t index ( const Player player_ ) noexcept {
+        // As Player::as_01index ( ), of an occupied player_ (within the bounds of m_stones, as the
+        // compiler can see).
+        assert ( player_.occupied ( ) );
+        return player_ == Player::Type::agent ? 0 : 1;
+    }
+
+    [[ nodiscard ]] ZobristHash hash ( ) const noexcept {
+        ZobristHash h = OskaStateTemplate<S>::m_zobrist_player_keys [ ( index_t ) Player::Type::vacant ];
+        for ( index_t p = 0; p < 2; ++p ) {
+            for ( Bitboard b = m_stones [ p ]; b; b = bb::reset_lsb ( b ) ) {
+                h ^= m_zobrist_keys.at ( p, bb::lsb ( b ) );
+            }
+        }
+        return h;
+    }
+
+    [[ nodiscard ]] Sources sources ( const index_t p_ ) const noexcept {
+        const Bitboard mine = m_stones [ p_ ], theirs = m_stones [ p_ ^ 1 ], vacant = g.board & ~( mine | theirs );
+        Sources s;
+        s.m_stones [ Geometry::StepLeft ] = mine & g.source [ p_ ] [ Geometry::StepLeft ] & bb::rotl ( vacant, g.back [ p_ ] [ Geometry::StepLeft ] );
+        s.m_stones [ Geometry::StepRight ] = mine & g.source [ p_ ] [ Geometry::StepRight ] & bb::rotl ( vacant, g.back [ p_ ] [ Geometry::StepRight ] );
+        s.m_stones [ Geometry::JumpLeft ] = mine & g.source [ p_ ] [ Geometry::JumpLeft ] & bb::rotl ( theirs, g.back [ p_ ] [ Geometry::StepLeft ] ) & bb::rotl ( vacant, g.back [ p_ ] [ Geometry::JumpLeft ] );
+        s.m_stones [ Geometry::JumpRight ] = mine & g.source [ p_ ] [ Geometry::JumpRight ] & bb::rotl ( theirs, g.back [ p_ ] [ Geometry::StepRight ] ) & bb::rotl ( vacant, g.back [ p_ ] [ Geometry::JumpRight ] );
+        return s;
+    }
+
+    [[ nodiscard ]] static index_t target ( const index_t p_, const index_t d_, const index_t b_ ) noexcept {
+        return ( b_ + g.shift [ p_ ] [ d_ ] ) % Geometry::no_bits;
+    }
+
+    [[ nodiscard ]] static index_t captured ( const index_t p_, const index_t d_, const index_t b_ ) noexcept {
+        // The jumped-over stone of a jump, -1 for a step.
+        return d_ < Geometry::JumpLeft ? -1 : ( b_ + g.shift [ p_ ] [ d_ - 2 ] ) % Geometry::no_bits;
+    }
+
+    [[ nodiscard ]] static Location location ( const index_t p_, const index_t b_ ) noexcept {
+        // Bit to location, from the perspective of the player.
+        const typename Geometry::Cell cell = g.bit_to_cell [ b_ ];
+        return p_ ? Location ( ( OB_COLS ( S ) - 1 ) - cell.c, ( OB_ROWS ( S ) - 1 ) - cell.r ) : Location ( cell.c, cell.r );
+    }
+
+    [[ nodiscard ]] static index_t toBit ( const index_t p_, const Location & l_ ) noexcept {
+        // Location, from the perspective of the player, to bit.
+        return p_ ? g.cell_to_bit [ ( OB_COLS ( S ) - 1 ) - l_.c ] [ ( OB_ROWS ( S ) - 1 ) - l_.r ] : g.cell_to_bit [ l_.c ] [ l_.r ];
+    }
+
+    template<bool Hash>
+    void moveStone ( const index_t p_, const index_t f_, const index_t t_, const index_t c_ ) noexcept {
+        m_stones [ p_ ] ^= bb::bit<Bitboard> ( f_ ) | bb::bit<Bitboard> ( t_ );
+        if constexpr ( Hash ) {
+            m_zobrist_hash ^= m_zobrist_keys.at ( p_, f_ ) ^ m_zobrist_keys.at ( p_, t_ );
+        }
+        if ( c_ >= 0 ) {
+            m_stones [ p_ ^ 1 ] ^= bb::bit<Bitboard> ( c_ );
+            if constexpr ( Hash ) {
+                m_zobrist_hash ^= m_zobrist_keys.at ( p_ ^ 1, c_ );
+            }
+        }
+    }
+
+    template<bool Hash>
+    void moveStone ( const Move & move_ ) noexcept {
+        const index_t p = m_player_to_move.as_01index ( );
+        moveStone<Hash> ( p, toBit ( p, move_.m_from ), toBit ( p, move_.m_to ), move_.isCapture ( ) ? toBit ( p, move_.captured ( ) ) : -1 );
+    }
+
+public:
+
+    void move_hash ( const Move & move_ ) noexcept {
+        m_last_move = move_;
+        moveStone<true> ( move_ );
+        m_player_to_move.next ( );
+    }
+
+    void move_hash_winner ( const Move & move_ ) noexcept {
+        m_last_move = move_;
+        moveStone<true> ( move_ );
+        winner ( );
+        m_player_to_move.next ( );
+    }
+
+    void move_winner ( const Move & move_ ) noexcept {
+        m_last_move = move_;
+        moveStone<false> ( move_ );
+        winner ( );
+        m_player_to_move.next ( );
+    }
+
+    [[ maybe_unused ]] Move const doMove ( const Move & move_ ) noexcept {
+        move_hash ( move_ );
+        return move_;
+    }
+
+    [[ nodiscard ]] bool moves ( Moves * moves_ ) const noexcept {
+        // Mcts class takes has ownership.
+        if ( m_winner.occupied ( ) ) {
+            return false;
+        }
+        moves_->clear ( );
+        const index_t p = m_player_to_move.as_01index ( );
+        const Sources s = sources ( p );
+        for ( index_t d = Geometry::StepLeft; d <= Geometry::JumpRight; ++d ) {
+            for ( Bitboard b = s.m_stones [ d ]; b; b = bb::reset_lsb ( b ) ) {
+                const index_t f = bb::lsb ( b );
+                moves_->emplace_back ( Move ( location ( p, f ), location ( p, target ( p, d, f ) ) ) );
+            }
+        }
+        return moves_->size ( );
+    }
+
+    [[ nodiscard ]] bool hasMoves ( const Player player_ ) const noexcept {
+        const index_t p = index ( player_ );
+        return bb::Mobility<S>::hasMoves ( m_stones [ p ], m_stones [ p ^ 1 ], p );
+    }
+
+    [[ nodiscard ]] bool hasNoMoves ( const Player player_ ) const noexcept {
+        return not ( hasMoves ( player_ ) );
+    }
+
+    template<typename Policy = PlayoutPolicy>
+    void simulate ( ) noexcept {
+        // Play-out, straight on the bitboards, the moves picked by the Policy (see Playout.hpp), m_last_move
+        // is not updated. The play-out stops early with the exact result once the position is in the tablebase,
+        // the number of stones only goes down with a capture, so that's where it's probed.
+        const bool is_loaded = tb::Tablebase<S>::isLoaded ( );
+        bool probe = is_loaded;
+        while ( not ( m_winner.occupied ( ) ) ) {
+            if ( probe and m_winner == Player::Type::invalid ) {
+                const Player winner = tb::Tablebase<S>::winner ( m_stones, m_player_to_move );
+                if ( winner != Player::Type::invalid ) {
+                    m_winner = winner;
+                    break;
+                }
+            }
+            const Sources s = sources ( );
+            if ( ( s.m_stones [ Geometry::StepLeft ] | s.m_stones [ Geometry::StepRight ] | s.m_stones [ Geometry::JumpLeft ] | s.m_stones [ Geometry::JumpRight ] ) == Bitboard { } ) {
+                break;
+            }
+            const BitMove move = Policy::pick ( * this, s );
+            probe = is_loaded and move.d >= Geometry::JumpLeft;
+            play ( move );
+        }
+        if constexpr ( Policy::is_learning ) {
+            Policy::template finish<OskaBitStateTemplate> ( m_winner );
+        }
+    }
+
+    [[ nodiscard ]] Sources sources ( ) const noexcept {
+        // Of the player to move.
+        return sources ( m_player_to_move.as_01index ( ) );
+    }
+
+    [[ nodiscard ]] static BitMove bitMove ( const index_t p_, const Move & move_ ) noexcept {
+        // A move of player p_ (from the player's perspective, as Move is), left is to the higher column.
+        return { ( move_.m_to.c > move_.m_from.c ? Geometry::StepLeft : Geometry::StepRight ) + ( move_.isCapture ( ) ? 2 : 0 ), toBit ( p_, move_.m_from ) };
+    }
+
+    void play ( const BitMove & move_ ) noexcept {
+        // Without hashing, and m_last_move is not updated.
+        const index_t p = m_player_to_move.as_01index ( );
+        moveStone<false> ( p, move_.f, target ( p, move_.d, move_.f ), captured ( p, move_.d, move_.f ) );
+        winner ( );
+        m_player_to_move.next ( );
+    }
+
+    template<typename Policy = PlayoutPolicy, index_t N>
+    void playouts ( Player ( & winners_ ) [ N ] ) const noexcept {
+        // N random play-outs from this position, winners_ by play-out, only uniformly random play-outs run in lock-step.
+        if ( m_winner != Player::Type::invalid ) {
+            std::fill ( std::begin ( winners_ ), std::end ( winners_ ), m_winner );
+        }
+        else if ( const Player winner = tb::Tablebase<S>::winner ( m_stones, m_player_to_move ); winner != Player::Type::invalid ) {
+            std::fill ( std::begin ( winners_ ), std::end ( winners_ ), winner );
+        }
+        else if constexpr ( std::is_same_v<Bitboard, std::uint64_t> and std::is_same_v<Policy, po::Uniform> ) {
+            const std::uint64_t stones [ 2 ] = { m_stones [ 0 ], m_stones [ 1 ] };
+            bb::BatchPlayout<S, N> ( ).run ( stones, m_player_to_move.as_01index ( ), winners_ );
+        }
+        else {
+            for ( Player & winner : winners_ ) {
+                OskaBitStateTemplate state ( * this );
+                state.template simulate<Policy> ( );
+                winner = state.m_winner;
+            }
+        }
+    }
+
+    [[ nodiscard ]] std::optional<Player> ended ( ) const noexcept {
+        return m_winner == Player::Type::invalid ? std::optional<Player> ( ) : std::optional<Player> ( m_winner );
+    }
+
+    void winner ( ) noexcept { // Before the player swap, but after m_player_to_move made his move.
+        if ( haveRemainingHome ( m_player_to_move ) ) {
+            m_winner = haveRemainingHome ( m_player_to_move.opponent ( ) ) ? playerMostHomeStones ( ) : m_player_to_move;
+        }
+        else if ( notHaveStones ( m_player_to_move.opponent ( ) ) ) {
+            m_winner = m_player_to_move;
+        }
+        else if ( hasNoMoves ( m_player_to_move.opponent ( ) ) ) {
+            m_winner = m_player_to_move.opponent ( );
+        }
+    }
+
+    [[ nodiscard ]] float result ( const Player player_just_moved_ ) const noexcept {
+        return m_winner.vacant ( ) ? 0.0f : ( m_winner == player_just_moved_ ? 1.0f : -1.0f );
+    }
+
+    [[ nodiscard ]] bool terminal ( ) const noexcept {
+        return m_winner.occupied ( );
+    }
+
+    [[ nodiscard ]] bool nonterminal ( ) const noexcept {
+        return m_winner.vacant ( );
+    }
+
+    [[ nodiscard ]] Move lastMove ( ) const noexcept {
+        return m_last_move;
+    }
+
+    void print ( ) const noexcept {
+        // Agent's perspective.
+        putchar ( '\n' );
+        for ( index_t r = 0; r < OB_ROWS ( S ); ++r ) {
+            putchar ( ' ' );
+            for ( index_t c = 0; c < OB_COLS ( S ); ++c ) {
+                const index_t b = g.cell_to_bit [ c ] [ r ];
+                if ( b < 0 ) {
+                    putchar ( ' ' );
+                }
+                else {
+                    const Bitboard s = bb::bit<Bitboard> ( b );
+                    putchar ( ( m_stones [ 0 ] & s ) ? 'A' : ( ( m_stones [ 1 ] & s ) ? 'H' : '*' ) );
+                }
+                putchar ( ' ' );
+            }
+            putchar ( '\n' );
+        }
+        putchar ( '\n' );
+        std::cout << " Agent: has " << noStones ( Player::Type::agent ) << " stones (" << noHome ( Player::Type::agent ) << " stone(s) home)\n";
+        std::cout << " Human: has " << noStones ( Player::Type::human ) << " stones (" << noHome ( Player::Type::human ) << " stone(s) home)\n\n";
+    }
+};
+
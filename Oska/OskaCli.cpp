@@ -0,0 +1,74 @@
+
+// MIT License
+//
+// Copyright (c) 2018 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// The headless driver, the command line modes of Cli.hpp without SFML and Win32, with the
+// globals of Globals.cpp, e.g. on Linux:
+//
+//     g++ -std=c++17 -O3 -DNDEBUG -DOSKA_HEADLESS -pthread OskaCli.cpp Globals.cpp -ltbb -o oska
+//
+// (with boost, tbb, cereal, lz4stream, pector, integer_utils, autotimer and ska_sort, as for
+// the app, on the include path).
+
+#if not defined ( OSKA_HEADLESS )
+#define OSKA_HEADLESS
+#endif
+
+#include <cstdlib>
+
+#include <algorithm>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+
+#include "Cli.hpp"
+
+
+int main ( int argc_, char * argv_ [ ] ) {
+
+	try {
+
+		if ( const std::optional<std::int32_t> exit_code = cli::run ( std::vector<std::string> ( argv_ + 1, argv_ + argc_ ) ); exit_code ) {
+
+			return * exit_code;
+		}
+
+		cli::usage ( );
+
+		return EXIT_FAILURE;
+	}
+
+	catch ( const std::exception & e ) {
+
+		std::cout << "Caught exception \"" << e.what ( ) << "\"\n";
+
+		return EXIT_FAILURE;
+	}
+}
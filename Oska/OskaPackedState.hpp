@@ -0,0 +1,259 @@
+
+// MIT License
+//
+// Copyright (c) 2018 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#include <optional>
+
+#include <cereal/cereal.hpp>
+
+#include "Typedefs.hpp"
+#include "player.hpp"
+#include "moves.hpp"
+#include "Oska.hpp"
+#include "OskaBitState.hpp"
+
+
+// Packed Oska position (32 bytes), for copying, hashing and storage. The game logic
+// is that of OskaBitStateTemplate<S>, the hash is the same as that of the bitboard
+// state it was packed from, an UndoRecord is the packed state itself.
+
+template<index_t S>
+class OskaPackedStateTemplate { // 32
+
+public:
+
+    static constexpr index_t max_no_moves = 2 * S;
+
+    using Player = ::Player;
+    using ZobristHash = ::ZobristHash;
+    using Move = ::Move;
+    using Moves = ::Moves<Move, max_no_moves>;
+    using CompactMove = ::CompactMove;
+    using CompactMoves = ::Moves<CompactMove, max_no_moves>;
+    using UndoRecord = OskaPackedStateTemplate;
+    using PlayoutPolicy = po::Uniform;
+
+    using BitState = OskaBitStateTemplate<S>;
+
+private:
+
+    ZobristHash m_zobrist_hash = 0;
+
+    std::int8_t m_stone_id [ 2 ] [ 8 ];             // By Player::as_01index ( ), hexagon-ids (agent's perspective), -1 if none.
+
+    Move m_last_move = Move::root;
+
+    Player m_player_to_move = Player::Type::agent, m_winner = Player::Type::invalid;
+
+    std::int8_t m_no_home [ 2 ] = { 0, 0 };         // By Player::as_01index ( ).
+
+public:
+
+    OskaPackedStateTemplate ( ) noexcept {
+        std::memset ( m_stone_id, -1, sizeof ( m_stone_id ) );
+    }
+
+    explicit OskaPackedStateTemplate ( const BitState & s_ ) noexcept :
+        m_zobrist_hash ( s_.m_zobrist_hash ), m_last_move ( s_.m_last_move ), m_player_to_move ( s_.m_player_to_move ), m_winner ( s_.m_winner ) {
+        for ( index_t p = 0; p < 2; ++p ) {
+            index_t i = 0;
+            for ( typename BitState::Bitboard b = s_.m_stones [ p ]; b; b = bb::reset_lsb ( b ) ) {
+                m_stone_id [ p ] [ i++ ] = BitState::g.bit_to_id [ bb::lsb ( b ) ];
+            }
+            for ( ; i < 8; ++i ) {
+                m_stone_id [ p ] [ i ] = -1;
+            }
+            m_no_home [ p ] = ( std::int8_t ) bb::popcount ( s_.m_stones [ p ] & BitState::g.home [ p ] );
+        }
+    }
+
+    explicit OskaPackedStateTemplate ( const OskaStateTemplate<S> & s_ ) noexcept :
+        OskaPackedStateTemplate ( BitState ( s_ ) ) {
+    }
+
+    [[ nodiscard ]] BitState unpack ( ) const noexcept {
+        BitState s;
+        for ( index_t p = 0; p < 2; ++p ) {
+            for ( index_t i = 0; i < 8 and m_stone_id [ p ] [ i ] >= 0; ++i ) {
+                s.m_stones [ p ] |= bb::bit<typename BitState::Bitboard> ( BitState::g.id_to_bit [ m_stone_id [ p ] [ i ] ] );
+            }
+        }
+        s.m_zobrist_hash = m_zobrist_hash;
+        s.m_player_to_move = m_player_to_move;
+        s.m_winner = m_winner;
+        s.m_last_move = m_last_move;
+        return s;
+    }
+
+    void unpack ( OskaStateTemplate<S> & s_ ) const noexcept {
+        // The boards of s_ (which has to be initialized) are rebuilt from the stone-ids.
+        for ( const typename HexagonGeometry<S>::Cell & cell : HexagonGeometry<S>::tables.cell ) {
+            s_.m_agent_board.at ( cell.c, cell.r ) = s_.m_human_board.at_r ( cell.c, cell.r ) = Player::Type::vacant;
+        }
+        s_.m_agent_stone_id.clear ( );
+        s_.m_human_stone_id.clear ( );
+        for ( index_t i = 0; i < 8 and m_stone_id [ 0 ] [ i ] >= 0; ++i ) {
+            const typename HexagonGeometry<S>::Cell & cell = HexagonGeometry<S>::tables.cell [ m_stone_id [ 0 ] [ i ] ];
+            s_.m_agent_board.at ( cell.c, cell.r ) = s_.m_human_board.at_r ( cell.c, cell.r ) = Player::Type::agent;
+            s_.m_agent_stone_id.emplace_back ( m_stone_id [ 0 ] [ i ] );
+        }
+        for ( index_t i = 0; i < 8 and m_stone_id [ 1 ] [ i ] >= 0; ++i ) {
+            const typename HexagonGeometry<S>::Cell & cell = HexagonGeometry<S>::tables.cell [ m_stone_id [ 1 ] [ i ] ];
+            s_.m_agent_board.at ( cell.c, cell.r ) = s_.m_human_board.at_r ( cell.c, cell.r ) = Player::Type::human;
+            s_.m_human_stone_id.emplace_back ( m_stone_id [ 1 ] [ i ] );
+        }
+        s_.m_no_home_agent = m_no_home [ 0 ];
+        s_.m_no_home_human = m_no_home [ 1 ];
+        s_.m_player_to_move = m_player_to_move;
+        s_.m_winner = m_winner;
+        s_.m_last_move = m_last_move;
+        s_.rehash ( );
+        s_.remobilize ( );
+    }
+
+    void initialize ( ) noexcept {
+        BitState s;
+        s.initialize ( );
+        * this = OskaPackedStateTemplate ( s );
+    }
+
+    [[ nodiscard ]] static CompactMove compact ( const Move & m_ ) noexcept {
+        return HexagonGeometry<S>::compact ( m_ );
+    }
+
+    [[ nodiscard ]] static Move expand ( const CompactMove m_ ) noexcept {
+        return HexagonGeometry<S>::expand ( m_ );
+    }
+
+    [[ nodiscard ]] ZobristHash zobrist ( ) const noexcept {
+        return m_zobrist_hash ^ OskaStateTemplate<S>::m_zobrist_player_keys [ m_player_to_move.as_index ( ) ];
+    }
+
+    [[ nodiscard ]] Player playerToMove ( ) const noexcept {
+        return m_player_to_move;
+    }
+
+    [[ nodiscard ]] Player playerJustMoved ( ) const noexcept {
+        return m_player_to_move.opponent ( );
+    }
+
+    [[ nodiscard ]] index_t noHome ( const Player player_ ) const noexcept {
+        return m_no_home [ player_.as_01index ( ) ];
+    }
+
+    [[ nodiscard ]] bool moves ( Moves * moves_ ) const noexcept {
+        return unpack ( ).moves ( moves_ );
+    }
+
+    void move_hash ( const Move & move_ ) noexcept {
+        BitState s ( unpack ( ) );
+        s.move_hash ( move_ );
+        * this = OskaPackedStateTemplate ( s );
+    }
+
+    void move_hash_winner ( const Move & move_ ) noexcept {
+        BitState s ( unpack ( ) );
+        s.move_hash_winner ( move_ );
+        * this = OskaPackedStateTemplate ( s );
+    }
+
+    void move_winner ( const Move & move_ ) noexcept {
+        move_hash_winner ( move_ ); // The hash comes for free.
+    }
+
+    [[ maybe_unused ]] Move const doMove ( const Move & move_ ) noexcept {
+        move_hash ( move_ );
+        return move_;
+    }
+
+    void make_hash ( const Move & move_, UndoRecord & undo_ ) noexcept {
+        undo_ = * this;
+        move_hash ( move_ );
+    }
+
+    void make_hash_winner ( const Move & move_, UndoRecord & undo_ ) noexcept {
+        undo_ = * this;
+        move_hash_winner ( move_ );
+    }
+
+    void unmake ( const Move &, const UndoRecord & undo_ ) noexcept {
+        * this = undo_;
+    }
+
+    template<typename Policy = PlayoutPolicy>
+    [[ nodiscard ]] Player playout ( ) const noexcept {
+        BitState s ( unpack ( ) );
+        s.template simulate<Policy> ( );
+        return * s.ended ( );
+    }
+
+    template<typename Policy = PlayoutPolicy, index_t N>
+    void playouts ( Player ( & winners_ ) [ N ] ) const noexcept {
+        unpack ( ).template playouts<Policy> ( winners_ );
+    }
+
+    template<typename Policy = PlayoutPolicy>
+    void simulate ( ) noexcept {
+        m_winner = playout<Policy> ( );
+    }
+
+    [[ nodiscard ]] std::optional<Player> ended ( ) const noexcept {
+        return m_winner == Player::Type::invalid ? std::optional<Player> ( ) : std::optional<Player> ( m_winner );
+    }
+
+    [[ nodiscard ]] float result ( const Player player_just_moved_ ) const noexcept {
+        return score ( m_winner, player_just_moved_ );
+    }
+
+    [[ nodiscard ]] static float score ( const Player winner_, const Player player_just_moved_ ) noexcept {
+        return OskaStateTemplate<S>::score ( winner_, player_just_moved_ );
+    }
+
+    [[ nodiscard ]] bool terminal ( ) const noexcept {
+        return m_winner.occupied ( );
+    }
+
+    [[ nodiscard ]] bool nonterminal ( ) const noexcept {
+        return m_winner.vacant ( );
+    }
+
+    [[ nodiscard ]] Move lastMove ( ) const noexcept {
+        return m_last_move;
+    }
+
+    void print ( ) const noexcept {
+        unpack ( ).print ( );
+    }
+
+private:
+
+    friend class cereal::access;
+
+    template < class Archive >
+    void serialize ( Archive & ar_ ) { ar_ ( cereal::binary_data ( this, sizeof ( OskaPackedStateTemplate ) ) ); }
+};
+
+static_assert ( sizeof ( OskaPackedStateTemplate<4> ) == 32 and sizeof ( OskaPackedStateTemplate<8> ) == 32, "OskaPackedStateTemplate is not 32 bytes" );
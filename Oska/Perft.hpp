@@ -0,0 +1,173 @@
+
+// MIT License
+//
+// Copyright (c) 2018 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+
+#include <chrono>
+
+#include "Typedefs.hpp"
+#include "Oska.hpp"
+
+
+// Perft, counting the leaf positions at a given depth from the initial position, to
+// verify (any) move generator against another and to measure their throughput, without
+// the app. The make path matters, move_hash ( ) doesn't determine the winner, so the
+// game continues until a player cannot move, move_winner ( ) stops at the winner.
+
+namespace pf {
+
+    template<typename State>
+    using MakeMove = void ( State::* ) ( const typename State::Move & ) noexcept;
+
+    template<typename State>
+    [[ nodiscard ]] std::uint64_t perft ( const State & state_, const index_t depth_, const MakeMove<State> make_ ) noexcept {
+        if ( not ( depth_ ) ) {
+            return 1;
+        }
+        typename State::Moves moves;
+        if ( not ( state_.moves ( & moves ) ) ) {
+            return 0;
+        }
+        std::uint64_t nodes = 0;
+        for ( index_t i = 0; i < moves.size ( ); ++i ) {
+            State state ( state_ );
+            ( state.*make_ ) ( moves.at ( i ) );
+            nodes += perft ( state, depth_ - 1, make_ );
+        }
+        return nodes;
+    }
+
+    // As perft ( ) with move_winner ( ), but the leaves are counted from the moves at
+    // depth 1 (bulk counting), i.e. mostly moves ( ) is measured.
+
+    template<typename State>
+    [[ nodiscard ]] std::uint64_t perftBulk ( const State & state_, const index_t depth_ ) noexcept {
+        if ( not ( depth_ ) ) {
+            return 1;
+        }
+        typename State::Moves moves;
+        if ( not ( state_.moves ( & moves ) ) ) {
+            return 0;
+        }
+        if ( 1 == depth_ ) {
+            return moves.size ( );
+        }
+        std::uint64_t nodes = 0;
+        for ( index_t i = 0; i < moves.size ( ); ++i ) {
+            State state ( state_ );
+            state.move_winner ( moves.at ( i ) );
+            nodes += perftBulk ( state, depth_ - 1 );
+        }
+        return nodes;
+    }
+
+
+    template<typename Function>
+    [[ nodiscard ]] std::uint64_t timed ( Function && f_, double & seconds_ ) noexcept {
+        const auto start = std::chrono::steady_clock::now ( );
+        const std::uint64_t nodes = f_ ( );
+        seconds_ = std::chrono::duration<double> ( std::chrono::steady_clock::now ( ) - start ).count ( );
+        return nodes;
+    }
+
+
+    // Report node counts and speeds of the three paths, for depths 1 to depth_, returns false
+    // if the counts of the bulk and move_winner ( ) paths differ.
+
+    template<typename State>
+    [[ maybe_unused ]] bool report ( const State & state_, const char * name_, const index_t depth_ ) noexcept {
+        bool is_valid = true;
+        std::printf ( "%s\n depth %16s %12s %16s %12s %16s %12s\n", name_, "moves ( )", "Mn/s", "move_hash ( )", "Mn/s", "move_winner ( )", "Mn/s" );
+        for ( index_t d = 1; d <= depth_; ++d ) {
+            double bulk_seconds, hash_seconds, winner_seconds;
+            const std::uint64_t bulk = timed ( [ & ] ( ) { return perftBulk ( state_, d ); }, bulk_seconds );
+            const std::uint64_t hash = timed ( [ & ] ( ) { return perft<State> ( state_, d, & State::move_hash ); }, hash_seconds );
+            const std::uint64_t winner = timed ( [ & ] ( ) { return perft<State> ( state_, d, & State::move_winner ); }, winner_seconds );
+            std::printf ( " %5i %16llu %12.2f %16llu %12.2f %16llu %12.2f\n", d,
+                ( unsigned long long ) bulk, bulk / bulk_seconds / 1e6,
+                ( unsigned long long ) hash, hash / hash_seconds / 1e6,
+                ( unsigned long long ) winner, winner / winner_seconds / 1e6 );
+            is_valid = is_valid and bulk == winner;
+        }
+        return is_valid;
+    }
+
+
+    // Node count (move_winner ( ) path) per root move.
+
+    template<typename State>
+    void divide ( const State & state_, const index_t depth_ ) noexcept {
+        typename State::Moves moves;
+        std::uint64_t nodes = 0;
+        if ( depth_ > 0 and state_.moves ( & moves ) ) {
+            for ( index_t i = 0; i < moves.size ( ); ++i ) {
+                const typename State::Move move = moves.at ( i );
+                State state ( state_ );
+                state.move_winner ( move );
+                const std::uint64_t n = perft<State> ( state, depth_ - 1, & State::move_winner );
+                std::printf ( " [%i, %i] -> [%i, %i] %llu\n", move.m_from.c, move.m_from.r, move.m_to.c, move.m_to.r, ( unsigned long long ) n );
+                nodes += n;
+            }
+        }
+        std::printf ( " total %llu\n", ( unsigned long long ) nodes );
+    }
+
+
+    // Perft of the array based and the bitboard state, for board size S, returns false if
+    // their node counts differ, or either is inconsistent.
+
+    template<index_t S>
+    [[ nodiscard ]] bool run ( const index_t depth_, const bool divide_ ) {
+        OskaStateTemplate<S> state;
+        state.initialize ( );
+        const OskaBitStateTemplate<S> bit_state ( state );
+        std::printf ( "\nOska %i, perft to depth %i\n\n", S, depth_ );
+        if ( divide_ ) {
+            divide ( state, depth_ );
+            divide ( bit_state, depth_ );
+            return true;
+        }
+        bool is_valid = report ( state, "OskaStateTemplate", depth_ );
+        is_valid = report ( bit_state, "OskaBitStateTemplate", depth_ ) and is_valid;
+        for ( index_t d = 1; d <= depth_; ++d ) {
+            is_valid = is_valid and perft<OskaStateTemplate<S>> ( state, d, & OskaStateTemplate<S>::move_hash ) == perft<OskaBitStateTemplate<S>> ( bit_state, d, & OskaBitStateTemplate<S>::move_hash );
+            is_valid = is_valid and perftBulk ( state, d ) == perftBulk ( bit_state, d );
+        }
+        std::printf ( "\n %s\n", is_valid ? "valid" : "INVALID" );
+        return is_valid;
+    }
+
+    // Board size 0 runs all sizes.
+
+    [[ nodiscard ]] inline bool run ( const index_t size_, const index_t depth_, const bool divide_ ) {
+        bool is_valid = true;
+        if ( not ( size_ ) or 4 == size_ ) is_valid = run<4> ( depth_, divide_ ) and is_valid;
+        if ( not ( size_ ) or 5 == size_ ) is_valid = run<5> ( depth_, divide_ ) and is_valid;
+        if ( not ( size_ ) or 6 == size_ ) is_valid = run<6> ( depth_, divide_ ) and is_valid;
+        if ( not ( size_ ) or 7 == size_ ) is_valid = run<7> ( depth_, divide_ ) and is_valid;
+        if ( not ( size_ ) or 8 == size_ ) is_valid = run<8> ( depth_, divide_ ) and is_valid;
+        return is_valid;
+    }
+}
@@ -0,0 +1,478 @@
+
+// MIT License
+//
+// Copyright (c) 2018 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <random>
+#include <type_traits>
+
+#include "Typedefs.hpp"
+#include "Globals.hpp"
+#include "player.hpp"
+#include "Oska.hpp"
+
+
+// Play-out policies, picking the moves of the play-outs of OskaBitStateTemplate<S>::simulate ( ).
+// The policy is chosen at compile time, as the Policy template parameter of playout ( ),
+// playouts ( ) and simulate ( ) of the states and of mcts::Mcts, which default to the state's
+// PlayoutPolicy (Uniform). A policy is a type with a static member function
+//
+//     template<typename BitState>
+//     typename BitState::BitMove pick ( const BitState & state_, const typename BitState::Sources & sources_ );
+//
+// returning one of the moves in sources_, the moves of the player to move in state_ (at least one),
+// and a static constexpr bool is_learning. A learning policy also has
+//
+//     template<typename BitState> void finish ( const Player winner_ );
+//     template<typename BitState> void update ( const Player player_, const typename BitState::Move & move_, const Player winner_ );
+//     template<typename BitState> void age ( );
+//
+// finish ( ) is called at the end of every play-out (winner_ is invalid if it was cut short),
+// update ( ) by mcts::Mcts for the moves of the tree part of an iteration, and age ( ) once
+// per search.
+
+namespace po {
+
+    // Number of moves in sources_.
+
+    template<typename BitState>
+    [[ nodiscard ]] index_t count ( const typename BitState::Sources & sources_ ) noexcept {
+        index_t n = 0;
+        for ( index_t d = BitState::Geometry::StepLeft; d <= BitState::Geometry::JumpRight; ++d ) {
+            n += bb::popcount ( sources_.m_stones [ d ] );
+        }
+        return n;
+    }
+
+    // The i_-th (from 0) move in sources_, by direction, then by bit.
+
+    template<typename BitState>
+    [[ nodiscard ]] typename BitState::BitMove nth ( const typename BitState::Sources & sources_, index_t i_ ) noexcept {
+        index_t d = BitState::Geometry::StepLeft;
+        for ( index_t n; i_ >= ( n = bb::popcount ( sources_.m_stones [ d ] ) ); ++d ) {
+            i_ -= n;
+        }
+        typename BitState::Bitboard b = sources_.m_stones [ d ];
+        for ( ; i_; --i_ ) {
+            b = bb::reset_lsb ( b );
+        }
+        return { d, bb::lsb ( b ) };
+    }
+
+    // Calls f_ with the moves in sources_ (in the order of nth ( )), until f_ returns true, returns
+    // whether it did.
+
+    template<typename BitState, typename Function>
+    bool forEach ( const typename BitState::Sources & sources_, Function && f_ ) {
+        for ( index_t d = BitState::Geometry::StepLeft; d <= BitState::Geometry::JumpRight; ++d ) {
+            for ( typename BitState::Bitboard b = sources_.m_stones [ d ]; b; b = bb::reset_lsb ( b ) ) {
+                if ( f_ ( typename BitState::BitMove { d, bb::lsb ( b ) } ) ) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+
+    // Uniformly random, the cheapest move and the default.
+
+    struct Uniform {
+
+        static constexpr bool is_learning = false;
+
+        template<typename BitState>
+        [[ nodiscard ]] static typename BitState::BitMove pick ( const BitState &, const typename BitState::Sources & sources_ ) noexcept {
+            return nth<BitState> ( sources_, std::uniform_int_distribution<index_t> ( 0, count<BitState> ( sources_ ) - 1 ) ( g_rng ) );
+        }
+    };
+
+
+    // Decisive and anti-decisive, a move that wins on the spot, if there is one, otherwise one
+    // (by Fallback) of the moves after which the opponent can't win on the spot, if there are
+    // any, otherwise any (by Fallback). Looks two plies ahead on every move, so a play-out is
+    // many times as expensive as a uniform one, but its results are much less noisy near the
+    // end of the game, where random play blunders most.
+
+    template<typename Fallback = Uniform>
+    struct Decisive {
+
+        static constexpr bool is_learning = Fallback::is_learning;
+
+        template<typename BitState>
+        [[ nodiscard ]] static typename BitState::BitMove pick ( const BitState & state_, const typename BitState::Sources & sources_ ) noexcept {
+            using BitMove = typename BitState::BitMove;
+            const Player player = state_.playerToMove ( );
+            typename BitState::Sources safe { };
+            BitMove win { };
+            bool has_safe = false;
+            if ( forEach<BitState> ( sources_, [ & ] ( const BitMove & move_ ) {
+                BitState state ( state_ );
+                state.play ( move_ );
+                if ( const std::optional<Player> winner = state.ended ( ); winner ) {
+                    if ( * winner == player ) {
+                        win = move_;
+                        return true;
+                    }
+                    if ( winner->occupied ( ) ) {
+                        return false;
+                    }
+                }
+                else if ( wins ( state ) ) {
+                    return false;
+                }
+                safe.m_stones [ move_.d ] |= bb::bit<typename BitState::Bitboard> ( move_.f );
+                has_safe = true;
+                return false;
+            } ) ) {
+                return win;
+            }
+            return Fallback::pick ( state_, has_safe ? safe : sources_ );
+        }
+
+        // A learning Fallback only learns from the moves it picked.
+
+        template<typename BitState>
+        static void finish ( const Player winner_ ) noexcept {
+            Fallback::template finish<BitState> ( winner_ );
+        }
+
+        template<typename BitState>
+        static void update ( const Player player_, const typename BitState::Move & move_, const Player winner_ ) noexcept {
+            Fallback::template update<BitState> ( player_, move_, winner_ );
+        }
+
+        template<typename BitState>
+        static void age ( ) noexcept {
+            Fallback::template age<BitState> ( );
+        }
+
+    private:
+
+        template<typename BitState>
+        [[ nodiscard ]] static bool wins ( const BitState & state_ ) noexcept {
+            // The player to move has a move that wins on the spot.
+            const Player player = state_.playerToMove ( );
+            return forEach<BitState> ( state_.sources ( ), [ & ] ( const typename BitState::BitMove & move_ ) {
+                BitState state ( state_ );
+                state.play ( move_ );
+                const std::optional<Player> winner = state.ended ( );
+                return winner and * winner == player;
+            } );
+        }
+    };
+
+
+    // Roulette-wheel selection, a capture weighs Capture, a move onto the far row weighs Home
+    // times as much (the weights multiply), all other moves weigh 1. Costs little more than
+    // Uniform, but strong weights make the play-outs predictable (and weaker), so keep them
+    // mild, or measure with run ( ).
+
+    template<index_t Capture = 2, index_t Home = 2>
+    struct Weighted {
+
+        static constexpr bool is_learning = false;
+
+        template<typename BitState>
+        [[ nodiscard ]] static typename BitState::BitMove pick ( const BitState & state_, const typename BitState::Sources & sources_ ) noexcept {
+            using Geometry = typename BitState::Geometry;
+            using Bitboard = typename BitState::Bitboard;
+            static constexpr const typename Geometry::Tables & g = Geometry::tables;
+            const index_t p = state_.playerToMove ( ).as_01index ( );
+            Bitboard stones [ 4 ] [ 2 ]; // By direction, not onto or onto the far row.
+            index_t weights [ 4 ] [ 2 ], total = 0;
+            for ( index_t d = Geometry::StepLeft; d <= Geometry::JumpRight; ++d ) {
+                stones [ d ] [ 1 ] = sources_.m_stones [ d ] & bb::rotl ( g.home [ p ], g.back [ p ] [ d ] );
+                stones [ d ] [ 0 ] = sources_.m_stones [ d ] ^ stones [ d ] [ 1 ];
+                weights [ d ] [ 0 ] = d >= Geometry::JumpLeft ? Capture : 1;
+                weights [ d ] [ 1 ] = weights [ d ] [ 0 ] * Home;
+                total += weights [ d ] [ 0 ] * bb::popcount ( stones [ d ] [ 0 ] ) + weights [ d ] [ 1 ] * bb::popcount ( stones [ d ] [ 1 ] );
+            }
+            index_t r = std::uniform_int_distribution<index_t> ( 0, total - 1 ) ( g_rng );
+            for ( index_t d = Geometry::StepLeft; d <= Geometry::JumpRight; ++d ) {
+                for ( index_t h = 0; h < 2; ++h ) {
+                    const index_t w = weights [ d ] [ h ] * bb::popcount ( stones [ d ] [ h ] );
+                    if ( r < w ) {
+                        Bitboard b = stones [ d ] [ h ];
+                        for ( index_t i = r / weights [ d ] [ h ]; i; --i ) {
+                            b = bb::reset_lsb ( b );
+                        }
+                        return { d, bb::lsb ( b ) };
+                    }
+                    r -= w;
+                }
+            }
+            return nth<BitState> ( sources_, 0 ); // Not reached.
+        }
+    };
+
+
+    // Move statistics, the mean play-out result by player, from-hexagon and direction (the
+    // jumps are the captures, so that includes capture or not), for MAST (move-average sampling
+    // technique). The table is fixed-size (8 KB for S = 8) and shared by all threads. An entry
+    // packs the visits (high 32 bits) and the score in half points (low 32 bits, a win counts 2,
+    // a draw 1), so that an update is a single relaxed fetch_add ( ), without locks. The keys
+    // of the moves of the current play-out are kept per thread, until the result is known.
+
+    template<typename BitState>
+    class MoveStatistics {
+
+        using Geometry = typename BitState::Geometry;
+        using BitMove = typename BitState::BitMove;
+
+        static constexpr index_t no_keys = 2 * Geometry::no_bits * 4, max_no_plies = BitState::max_no_moves * Geometry::no_rows;
+
+        alignas ( 64 ) static inline std::atomic<std::uint64_t> m_table [ no_keys ];
+
+        static inline thread_local std::uint16_t m_keys [ max_no_plies ];
+        static inline thread_local index_t m_no_keys = 0;
+
+    public:
+
+        [[ nodiscard ]] static index_t key ( const index_t p_, const BitMove & move_ ) noexcept {
+            return ( p_ * Geometry::no_bits + move_.f ) * 4 + move_.d;
+        }
+
+        [[ nodiscard ]] static float mean ( const index_t key_ ) noexcept {
+            // In [ 0, 1 ], a move without visits has a mean of 0.5.
+            const std::uint64_t entry = m_table [ key_ ].load ( std::memory_order_relaxed );
+            return ( ( entry & 0xFFFF'FFFF ) + 1 ) / ( 2.0f * ( ( entry >> 32 ) + 1 ) );
+        }
+
+        static void add ( const index_t key_, const Player winner_ ) noexcept {
+            const std::uint64_t score = winner_.vacant ( ) ? 1 : ( winner_.as_01index ( ) == key_ / ( Geometry::no_bits * 4 ) ? 2 : 0 );
+            m_table [ key_ ].fetch_add ( ( std::uint64_t { 1 } << 32 ) + score, std::memory_order_relaxed );
+        }
+
+        static void record ( const index_t key_ ) noexcept {
+            if ( m_no_keys < max_no_plies ) {
+                m_keys [ m_no_keys++ ] = ( std::uint16_t ) key_;
+            }
+        }
+
+        static void credit ( const Player winner_ ) noexcept {
+            // The recorded moves, with the result of the play-out.
+            if ( winner_ != Player::Type::invalid ) {
+                for ( index_t i = 0; i < m_no_keys; ++i ) {
+                    add ( m_keys [ i ], winner_ );
+                }
+            }
+            m_no_keys = 0;
+        }
+
+        static void age ( ) noexcept {
+            // Halves visits and score, so that recent play-outs weigh more (and the counts don't
+            // overflow). Updates racing with it are lost, that's harmless.
+            for ( std::atomic<std::uint64_t> & entry : m_table ) {
+                entry.store ( ( entry.load ( std::memory_order_relaxed ) >> 1 ) & 0x7FFF'FFFF'7FFF'FFFF, std::memory_order_relaxed );
+            }
+        }
+    };
+
+
+    // MAST, the moves picked by their mean result in the play-outs so far (MoveStatistics),
+    // epsilon-greedy, with Epsilon in percent, or, with a Temperature (in hundredths) other
+    // than 0, by Gibbs sampling, in proportion to exp ( mean / temperature ), all with
+    // uniformly random ties. Learns during a search, from all of its threads.
+
+    template<index_t Epsilon = 10, index_t Temperature = 0>
+    struct Mast {
+
+        static constexpr bool is_learning = true;
+
+        template<typename BitState>
+        [[ nodiscard ]] static typename BitState::BitMove pick ( const BitState & state_, const typename BitState::Sources & sources_ ) noexcept {
+            using BitMove = typename BitState::BitMove;
+            using Statistics = MoveStatistics<BitState>;
+            const index_t p = state_.playerToMove ( ).as_01index ( );
+            BitMove move;
+            if ( std::uniform_int_distribution<index_t> ( 0, 99 ) ( g_rng ) < Epsilon ) {
+                move = Uniform::pick ( state_, sources_ );
+            }
+            else if constexpr ( Temperature > 0 ) {
+                BitMove moves [ BitState::max_no_moves ];
+                float weights [ BitState::max_no_moves ], total = 0.0f;
+                index_t no_moves = 0;
+                forEach<BitState> ( sources_, [ & ] ( const BitMove & move_ ) {
+                    moves [ no_moves ] = move_;
+                    total += weights [ no_moves++ ] = std::exp ( Statistics::mean ( Statistics::key ( p, move_ ) ) * ( 100.0f / Temperature ) );
+                    return false;
+                } );
+                float r = std::uniform_real_distribution<float> ( 0.0f, total ) ( g_rng );
+                index_t i = 0;
+                for ( ; i < no_moves - 1 and r >= weights [ i ]; ++i ) {
+                    r -= weights [ i ];
+                }
+                move = moves [ i ];
+            }
+            else {
+                float best = -1.0f;
+                index_t no_ties = 0;
+                forEach<BitState> ( sources_, [ & ] ( const BitMove & move_ ) {
+                    const float mean = Statistics::mean ( Statistics::key ( p, move_ ) );
+                    if ( mean > best ) {
+                        best = mean, move = move_, no_ties = 1;
+                    }
+                    else if ( mean == best and not ( std::uniform_int_distribution<index_t> ( 0, no_ties++ ) ( g_rng ) ) ) {
+                        move = move_;
+                    }
+                    return false;
+                } );
+            }
+            Statistics::record ( Statistics::key ( p, move ) );
+            return move;
+        }
+
+        template<typename BitState>
+        static void finish ( const Player winner_ ) noexcept {
+            MoveStatistics<BitState>::credit ( winner_ );
+        }
+
+        template<typename BitState>
+        static void update ( const Player player_, const typename BitState::Move & move_, const Player winner_ ) noexcept {
+            const index_t p = player_.as_01index ( );
+            MoveStatistics<BitState>::add ( MoveStatistics<BitState>::key ( p, BitState::bitMove ( p, move_ ) ), winner_ );
+        }
+
+        template<typename BitState>
+        static void age ( ) noexcept {
+            MoveStatistics<BitState>::age ( );
+        }
+    };
+
+
+    // Benchmark. The cost of a policy is its number of play-outs per second from the initial
+    // position, its strength the score of a flat Monte-Carlo player (the root moves get a
+    // play-out each in turn, until the time per move is up, the best average is played) using
+    // it, against the same player using Uniform, at the same CPU time per move. So a policy
+    // that's smarter, but too slow, loses.
+
+    template<typename Policy, index_t S>
+    [[ nodiscard ]] double playoutsPerSecond ( const double seconds_ ) noexcept {
+        OskaBitStateTemplate<S> root;
+        root.initialize ( );
+        std::uint64_t n = 0;
+        const auto start = std::chrono::steady_clock::now ( );
+        double seconds = 0.0;
+        do {
+            for ( index_t i = 0; i < 256; ++i, ++n ) {
+                OskaBitStateTemplate<S> state ( root );
+                state.template simulate<Policy> ( );
+            }
+            seconds = std::chrono::duration<double> ( std::chrono::steady_clock::now ( ) - start ).count ( );
+        } while ( seconds < seconds_ );
+        return n / seconds;
+    }
+
+    template<typename Policy, index_t S>
+    [[ nodiscard ]] typename OskaBitStateTemplate<S>::BitMove flat ( const OskaBitStateTemplate<S> & state_, const double seconds_ ) noexcept {
+        using BitState = OskaBitStateTemplate<S>;
+        using BitMove = typename BitState::BitMove;
+        const Player player = state_.playerToMove ( );
+        BitMove moves [ BitState::max_no_moves ];
+        index_t no_moves = 0;
+        forEach<BitState> ( state_.sources ( ), [ & ] ( const BitMove & move_ ) { moves [ no_moves++ ] = move_; return false; } );
+        if ( 1 == no_moves ) {
+            return moves [ 0 ];
+        }
+        if constexpr ( Policy::is_learning ) {
+            Policy::template age<BitState> ( );
+        }
+        double scores [ BitState::max_no_moves ] { };
+        const auto deadline = std::chrono::steady_clock::now ( ) + std::chrono::duration<double> ( seconds_ );
+        do {
+            for ( index_t i = 0; i < no_moves; ++i ) {
+                BitState state ( state_ );
+                state.play ( moves [ i ] );
+                state.template simulate<Policy> ( );
+                const std::optional<Player> winner = state.ended ( );
+                scores [ i ] += not ( winner ) or winner->vacant ( ) ? 0.5 : ( * winner == player ? 1.0 : 0.0 );
+            }
+        } while ( std::chrono::steady_clock::now ( ) < deadline );
+        return moves [ std::max_element ( scores, scores + no_moves ) - scores ];
+    }
+
+    // Score (win 1, draw 0.5) of flat<Policy> ( ) against flat<Uniform> ( ) over games_ games,
+    // alternating sides, the player to move first is random.
+
+    template<typename Policy, index_t S>
+    [[ nodiscard ]] double match ( const double seconds_per_move_, const index_t games_ ) noexcept {
+        double score = 0.0;
+        for ( index_t i = 0; i < games_; ++i ) {
+            const Player player = i % 2 ? Player::Type::human : Player::Type::agent;
+            OskaBitStateTemplate<S> state;
+            state.initialize ( );
+            std::optional<Player> winner;
+            while ( not ( winner = state.ended ( ) ) ) {
+                state.play ( state.playerToMove ( ) == player ? flat<Policy, S> ( state, seconds_per_move_ ) : flat<Uniform, S> ( state, seconds_per_move_ ) );
+            }
+            score += winner->vacant ( ) ? 0.5 : ( * winner == player ? 1.0 : 0.0 );
+        }
+        return score / games_;
+    }
+
+    template<typename Policy, index_t S>
+    void report ( const char * name_, const double seconds_per_move_, const index_t games_ ) noexcept {
+        const double rate = playoutsPerSecond<Policy, S> ( 1.0 );
+        std::printf ( " %-20s %14.0f", name_, rate );
+        if constexpr ( std::is_same_v<Policy, Uniform> ) {
+            std::printf ( " %10s %10s\n", "-", "-" );
+        }
+        else {
+            std::fflush ( stdout );
+            const double score = match<Policy, S> ( seconds_per_move_, games_ ), clamped = std::clamp ( score, 0.001, 0.999 );
+            std::printf ( " %9.1f%% %+10.0f\n", 100.0 * score, -400.0 * std::log10 ( 1.0 / clamped - 1.0 ) );
+        }
+    }
+
+    template<index_t S>
+    void run ( const index_t milliseconds_per_move_, const index_t games_ ) noexcept {
+        const double seconds_per_move = milliseconds_per_move_ / 1000.0;
+        std::printf ( "\nOska %i, play-out policies, flat Monte-Carlo against uniform, %i ms per move, %i games\n\n", S, milliseconds_per_move_, games_ );
+        std::printf ( " %-20s %14s %10s %10s\n", "policy", "play-outs/s", "score", "elo" );
+        report<Uniform, S> ( "uniform", seconds_per_move, games_ );
+        report<Decisive<>, S> ( "decisive", seconds_per_move, games_ );
+        report<Weighted<>, S> ( "weighted", seconds_per_move, games_ );
+        report<Decisive<Weighted<>>, S> ( "decisive weighted", seconds_per_move, games_ );
+        report<Mast<>, S> ( "mast", seconds_per_move, games_ );
+        report<Mast<0, 10>, S> ( "mast gibbs", seconds_per_move, games_ );
+    }
+
+    [[ maybe_unused ]] inline bool run ( const index_t size_, const index_t milliseconds_per_move_, const index_t games_ ) {
+        switch ( size_ ) {
+            case 4: run<4> ( milliseconds_per_move_, games_ ); return true;
+            case 5: run<5> ( milliseconds_per_move_, games_ ); return true;
+            case 6: run<6> ( milliseconds_per_move_, games_ ); return true;
+            case 7: run<7> ( milliseconds_per_move_, games_ ); return true;
+            case 8: run<8> ( milliseconds_per_move_, games_ ); return true;
+            default: return false;
+        }
+    }
+}
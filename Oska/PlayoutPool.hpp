@@ -0,0 +1,217 @@
+
+// MIT License
+//
+// Copyright (c) 2018 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+
+#pragma once
+
+#include <cstdint>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Typedefs.hpp"
+#include "player.hpp"
+
+
+namespace mcts {
+
+    // The results of a number of play-outs, the number of wins by winner (agent, vacant, i.e. a
+    // draw, and human, by Player::as_index ( ) + 1). The back-up of the play-outs of a leaf is
+    // one pass over the path, with the sum of the scores and the number of play-outs.
+
+    struct Tally {
+
+        std::int32_t m_wins [ 3 ] = { 0, 0, 0 };
+
+        void add ( const Player winner_ ) noexcept {
+            ++m_wins [ winner_.as_index ( ) + 1 ];
+        }
+
+        Tally & operator += ( const Tally & tally_ ) noexcept {
+            for ( index_t i = 0; i < 3; ++i ) {
+                m_wins [ i ] += tally_.m_wins [ i ];
+            }
+            return * this;
+        }
+
+        [[ nodiscard ]] static Player winner ( const index_t i_ ) noexcept {
+            return Player ( ( Player::Type ) ( i_ - 1 ) );
+        }
+
+        [[ nodiscard ]] std::int32_t size ( ) const noexcept {
+            return m_wins [ 0 ] + m_wins [ 1 ] + m_wins [ 2 ];
+        }
+
+        template<typename State>
+        [[ nodiscard ]] float score ( const Player player_just_moved_ ) const noexcept {
+            float score = 0.0f;
+            for ( index_t i = 0; i < 3; ++i ) {
+                score += ( float ) m_wins [ i ] * State::score ( winner ( i ), player_just_moved_ );
+            }
+            return score;
+        }
+    };
+
+
+    // Leaf parallelization, a pool of no_threads_ - 1 threads (the thread calling run ( ) is the
+    // other one) doing the play-outs of a leaf. The play-outs are split in (about) one unit per
+    // thread, the threads claim the units off an atomic counter until none are left, and the
+    // tallies of the threads are summed. A unit is played out in batches of at most batch_size
+    // (run in lock-step by the state, if the Policy allows). At most batch_size play-outs don't
+    // pay for the hand-off, they are done by the calling thread.
+
+    template<typename State, typename Policy = typename State::PlayoutPolicy>
+    class PlayoutPool {
+
+    public:
+
+        static constexpr index_t batch_size = 8;
+
+    private:
+
+        std::vector<std::thread> m_threads;
+        std::mutex m_mutex;
+        std::condition_variable m_start, m_finish;
+
+        const State * m_state = nullptr;
+        index_t m_no_playouts = 0, m_unit = 0, m_generation = 0, m_no_busy = 0;
+        std::atomic<index_t> m_next { 0 };
+        Tally m_tally;
+        bool m_stop = false;
+
+    public:
+
+        explicit PlayoutPool ( const index_t no_threads_ ) {
+            for ( index_t t = 1; t < no_threads_; ++t ) {
+                m_threads.emplace_back ( [ this ] ( ) { work ( ); } );
+            }
+        }
+
+        PlayoutPool ( const PlayoutPool & ) = delete;
+        PlayoutPool & operator = ( const PlayoutPool & ) = delete;
+
+        ~PlayoutPool ( ) noexcept {
+            {
+                std::lock_guard<std::mutex> lock ( m_mutex );
+                m_stop = true;
+            }
+            m_start.notify_all ( );
+            for ( std::thread & thread : m_threads ) {
+                thread.join ( );
+            }
+        }
+
+        [[ nodiscard ]] index_t noThreads ( ) const noexcept {
+            return ( index_t ) m_threads.size ( ) + 1;
+        }
+
+        // The tally of no_playouts_ play-outs of state_ (left unchanged).
+
+        [[ nodiscard ]] Tally run ( const State & state_, const index_t no_playouts_ ) noexcept {
+            if ( m_threads.empty ( ) or no_playouts_ <= batch_size ) {
+                return playouts ( state_, no_playouts_ );
+            }
+            const index_t unit = ( no_playouts_ + noThreads ( ) - 1 ) / noThreads ( );
+            {
+                std::lock_guard<std::mutex> lock ( m_mutex );
+                m_state = & state_;
+                m_no_playouts = no_playouts_;
+                m_unit = unit;
+                m_next.store ( 0, std::memory_order_relaxed );
+                m_tally = Tally ( );
+                m_no_busy = ( index_t ) m_threads.size ( );
+                ++m_generation;
+            }
+            m_start.notify_all ( );
+            Tally tally;
+            claim ( state_, no_playouts_, unit, tally );
+            std::unique_lock<std::mutex> lock ( m_mutex );
+            m_finish.wait ( lock, [ this ] ( ) { return not ( m_no_busy ); } );
+            return tally += m_tally;
+        }
+
+        // As run ( ), on the calling thread only.
+
+        [[ nodiscard ]] static Tally playouts ( const State & state_, const index_t no_playouts_ ) noexcept {
+            Tally tally;
+            for ( index_t i = 0; i < no_playouts_; i += batch_size ) {
+                batch ( state_, std::min ( batch_size, no_playouts_ - i ), tally );
+            }
+            return tally;
+        }
+
+    private:
+
+        void work ( ) noexcept {
+            index_t generation = 0;
+            while ( true ) {
+                std::unique_lock<std::mutex> lock ( m_mutex );
+                m_start.wait ( lock, [ this, generation ] ( ) { return m_stop or m_generation != generation; } );
+                if ( m_stop ) {
+                    return;
+                }
+                generation = m_generation;
+                const State & state = * m_state;
+                const index_t no_playouts = m_no_playouts, unit = m_unit;
+                lock.unlock ( );
+                Tally tally;
+                claim ( state, no_playouts, unit, tally );
+                lock.lock ( );
+                m_tally += tally;
+                if ( not ( --m_no_busy ) ) {
+                    m_finish.notify_one ( );
+                }
+            }
+        }
+
+        void claim ( const State & state_, const index_t no_playouts_, const index_t unit_, Tally & tally_ ) noexcept {
+            for ( index_t i; ( i = m_next.fetch_add ( unit_, std::memory_order_relaxed ) ) < no_playouts_; ) {
+                tally_ += playouts ( state_, std::min ( unit_, no_playouts_ - i ) );
+            }
+        }
+
+        template<index_t N>
+        static void batch ( const State & state_, Tally & tally_ ) noexcept {
+            Player winners [ N ];
+            state_.template playouts<Policy> ( winners );
+            for ( const Player winner : winners ) {
+                tally_.add ( winner );
+            }
+        }
+
+        static void batch ( const State & state_, const index_t n_, Tally & tally_ ) noexcept {
+            switch ( n_ ) {
+                case 1: batch<1> ( state_, tally_ ); break;
+                case 2: batch<2> ( state_, tally_ ); break;
+                case 3: batch<3> ( state_, tally_ ); break;
+                case 4: batch<4> ( state_, tally_ ); break;
+                case 5: batch<5> ( state_, tally_ ); break;
+                case 6: batch<6> ( state_, tally_ ); break;
+                case 7: batch<7> ( state_, tally_ ); break;
+                case 8: batch<8> ( state_, tally_ ); break;
+            }
+        }
+    };
+}
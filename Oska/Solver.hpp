@@ -0,0 +1,294 @@
+
+// MIT License
+//
+// Copyright (c) 2018 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Typedefs.hpp"
+#include "Globals.hpp"
+#include "player.hpp"
+#include "Oska.hpp"
+
+
+// Exact solver, negamax with alpha-beta over win (1), draw (0) and loss (-1) for the player
+// to move. The threads search the same root, each with its own move ordering, and share
+// their results through a lock-free transposition table (Lazy SMP), the first thread to
+// finish has the value and stops the others.
+
+namespace sv {
+
+    // Lock-free transposition table, an entry is stored as ( key ^ data, data ), a torn
+    // write fails the key check on probing and reads as a miss.
+
+    class TranspositionTable {
+
+        struct Entry { // 16
+            std::atomic<std::uint64_t> m_check { 0 }, m_data { 0 };
+        };
+
+        std::unique_ptr<Entry [ ]> m_entries;
+        std::uint64_t m_mask;
+
+    public:
+
+        enum Bound : std::uint64_t { None = 0, Exact, Lower, Upper };
+
+        // Data, the value + 1 (2 bits), the bound (2 bits) and the index of the best move in
+        // the moves ( ) of the position (4 bits).
+
+        struct Data {
+            index_t m_value = 0, m_move = -1;
+            Bound m_bound = None;
+        };
+
+        explicit TranspositionTable ( const index_t log2_size_ ) :
+            m_entries ( new Entry [ std::size_t { 1 } << log2_size_ ] ),
+            m_mask ( ( std::uint64_t { 1 } << log2_size_ ) - 1 ) {
+        }
+
+        [[ nodiscard ]] Data probe ( const ZobristHash key_ ) const noexcept {
+            const Entry & e = m_entries [ key_ & m_mask ];
+            const std::uint64_t data = e.m_data.load ( std::memory_order_relaxed );
+            if ( ( e.m_check.load ( std::memory_order_relaxed ) ^ data ) != key_ ) {
+                return Data ( );
+            }
+            Data d;
+            d.m_value = ( index_t ) ( data & 3 ) - 1;
+            d.m_bound = Bound ( ( data >> 2 ) & 3 );
+            d.m_move = ( index_t ) ( ( data >> 4 ) & 15 );
+            return d;
+        }
+
+        void store ( const ZobristHash key_, const index_t value_, const Bound bound_, const index_t move_ ) noexcept {
+            const std::uint64_t data = std::uint64_t ( value_ + 1 ) | ( std::uint64_t ( bound_ ) << 2 ) | ( std::uint64_t ( move_ & 15 ) << 4 );
+            Entry & e = m_entries [ key_ & m_mask ];
+            e.m_check.store ( key_ ^ data, std::memory_order_relaxed );
+            e.m_data.store ( data, std::memory_order_relaxed );
+        }
+    };
+
+
+    template<index_t S>
+    class Solver {
+
+    public:
+
+        using State = OskaStateTemplate<S>;
+        using Move = typename State::Move;
+        using Moves = typename State::Moves;
+        using UndoRecord = typename State::UndoRecord;
+
+        static_assert ( State::max_no_moves <= 16, "a move index is stored in 4 bits" );
+
+        struct Result {
+            index_t m_value = 0; // For the player to move.
+            std::vector<Move> m_pv;
+            std::uint64_t m_nodes = 0;
+            double m_seconds = 0.0;
+        };
+
+    private:
+
+        TranspositionTable m_tt;
+        std::atomic<bool> m_stop { false };
+
+        struct Search {
+
+            Solver & m_solver;
+            State m_state;
+            index_t m_thread;
+            std::uint64_t m_nodes = 0;
+
+            Search ( Solver & solver_, const State & state_, const index_t thread_ ) noexcept :
+                m_solver ( solver_ ),
+                m_state ( state_ ),
+                m_thread ( thread_ ) {
+            }
+
+            [[ nodiscard ]] index_t negamax ( index_t alpha_, const index_t beta_ ) noexcept {
+                ++m_nodes;
+                const ZobristHash key = m_state.zobrist ( );
+                const TranspositionTable::Data data = m_solver.m_tt.probe ( key );
+                if ( data.m_bound == TranspositionTable::Exact
+                     or ( data.m_bound == TranspositionTable::Lower and data.m_value >= beta_ )
+                     or ( data.m_bound == TranspositionTable::Upper and data.m_value <= alpha_ ) ) {
+                    return data.m_value;
+                }
+                Moves moves;
+                if ( not ( m_state.moves ( & moves ) ) ) {
+                    return 1; // Not reachable, a player without moves has won (as in winner ( )).
+                }
+                // Move ordering, the move from the table, captures, the rest rotated by thread.
+                const index_t no_moves = moves.size ( ), first = data.m_bound not_eq TranspositionTable::None and data.m_move < no_moves ? data.m_move : -1;
+                index_t order [ State::max_no_moves ], n = 0;
+                if ( first >= 0 ) {
+                    order [ n++ ] = first;
+                }
+                for ( index_t capture = 1; capture >= 0; --capture ) {
+                    for ( index_t j = 0; j < no_moves; ++j ) {
+                        const index_t i = ( j + m_thread ) % no_moves;
+                        if ( i not_eq first and moves.at ( i ).isCapture ( ) == ( bool ) capture ) {
+                            order [ n++ ] = i;
+                        }
+                    }
+                }
+                const index_t alpha = alpha_;
+                const Player player = m_state.playerToMove ( );
+                index_t best = -2, best_move = 0;
+                for ( index_t k = 0; k < n; ++k ) {
+                    const Move move = moves.at ( order [ k ] );
+                    UndoRecord undo;
+                    m_state.make_hash_winner ( move, undo );
+                    const std::optional<Player> winner = m_state.ended ( );
+                    const index_t value = winner ? ( winner->vacant ( ) ? 0 : ( * winner == player ? 1 : -1 ) ) : -negamax ( -beta_, -alpha_ );
+                    m_state.unmake ( move, undo );
+                    if ( m_solver.m_stop.load ( std::memory_order_relaxed ) ) {
+                        return 0; // Aborted, nothing is stored.
+                    }
+                    if ( value > best ) {
+                        best = value, best_move = order [ k ];
+                        if ( ( alpha_ = std::max ( alpha_, value ) ) >= beta_ ) {
+                            break;
+                        }
+                    }
+                }
+                m_solver.m_tt.store ( key, best, best <= alpha ? TranspositionTable::Upper : best >= beta_ ? TranspositionTable::Lower : TranspositionTable::Exact, best_move );
+                return best;
+            }
+        };
+
+    public:
+
+        explicit Solver ( const index_t log2_tt_size_ = 24 ) : m_tt ( log2_tt_size_ ) {
+        }
+
+        [[ nodiscard ]] Result solve ( const State & state_, index_t no_threads_ = 0 ) {
+            if ( no_threads_ < 1 ) {
+                no_threads_ = std::max ( 1, ( index_t ) getNumberOfProcessors ( ) );
+            }
+            const auto start = std::chrono::steady_clock::now ( );
+            m_stop = false;
+            std::vector<std::unique_ptr<Search>> searches;
+            for ( index_t t = 0; t < no_threads_; ++t ) {
+                searches.emplace_back ( new Search ( * this, state_, t ) );
+            }
+            Result result;
+            std::atomic<bool> is_done { false };
+            auto work = [ & ] ( Search & search_ ) {
+                const index_t value = search_.negamax ( -1, 1 );
+                if ( not ( is_done.exchange ( true ) ) ) {
+                    result.m_value = value;
+                    m_stop = true;
+                }
+            };
+            std::vector<std::thread> threads;
+            for ( index_t t = 1; t < no_threads_; ++t ) {
+                threads.emplace_back ( work, std::ref ( * searches [ t ] ) );
+            }
+            work ( * searches [ 0 ] );
+            for ( std::thread & thread : threads ) {
+                thread.join ( );
+            }
+            for ( const auto & search : searches ) {
+                result.m_nodes += search->m_nodes;
+            }
+            result.m_seconds = std::chrono::duration<double> ( std::chrono::steady_clock::now ( ) - start ).count ( );
+            result.m_pv = pv ( state_ );
+            return result;
+        }
+
+        [[ nodiscard ]] std::vector<Move> pv ( State state_ ) {
+            // Following the best moves in the table, as long as their values are exact (a win
+            // from a lower bound and a loss from an upper bound are) and consistent. A position
+            // of which the entry is not (or no longer, it can have been overwritten) is searched
+            // again with a full window, the pv runs to the end of the game.
+            std::vector<Move> pv;
+            Moves moves;
+            m_stop = false;
+            for ( index_t value = m_tt.probe ( state_.zobrist ( ) ).m_value; not ( state_.ended ( ) ) and state_.moves ( & moves ); value = -value ) {
+                TranspositionTable::Data data = m_tt.probe ( state_.zobrist ( ) );
+                if ( not ( isExact ( data, value, moves.size ( ) ) ) ) {
+                    Search search ( * this, state_, 0 );
+                    const index_t searched_value = search.negamax ( -1, 1 );
+                    data = m_tt.probe ( state_.zobrist ( ) );
+                    if ( not ( isExact ( data, searched_value, moves.size ( ) ) ) ) {
+                        break; // Not reachable, the entry of the root of a search is stored last.
+                    }
+                }
+                value = data.m_value;
+                pv.push_back ( moves.at ( data.m_move ) );
+                state_.move_hash_winner ( pv.back ( ) );
+            }
+            return pv;
+        }
+
+    private:
+
+        [[ nodiscard ]] static bool isExact ( const TranspositionTable::Data & data_, const index_t value_, const index_t no_moves_ ) noexcept {
+            return ( data_.m_bound == TranspositionTable::Exact
+                     or ( data_.m_bound == TranspositionTable::Lower and data_.m_value == 1 )
+                     or ( data_.m_bound == TranspositionTable::Upper and data_.m_value == -1 ) )
+                and data_.m_value == value_ and data_.m_move < no_moves_;
+        }
+    };
+
+
+    // Solve the initial position of board size S, for either player to move first.
+
+    template<index_t S>
+    [[ maybe_unused ]] void run ( const index_t no_threads_, const index_t log2_tt_size_ ) {
+        static const char * const values [ 3 ] = { "loss", "draw", "win" };
+        for ( const Player first : { Player ( Player::Type::agent ), Player ( Player::Type::human ) } ) {
+            OskaStateTemplate<S> state;
+            state.initialize ( first );
+            Solver<S> solver ( log2_tt_size_ );
+            const typename Solver<S>::Result result = solver.solve ( state, no_threads_ );
+            std::printf ( "\nOska %i, %s to move: %s for the player to move\n", S, first == Player::Type::agent ? "agent" : "human", values [ result.m_value + 1 ] );
+            std::printf ( " %llu nodes in %.2f s, %.2f Mn/s\n pv", ( unsigned long long ) result.m_nodes, result.m_seconds, result.m_nodes / result.m_seconds / 1e6 );
+            for ( const Move & move : result.m_pv ) {
+                std::printf ( " [%i, %i] -> [%i, %i]", move.m_from.c, move.m_from.r, move.m_to.c, move.m_to.r );
+            }
+            std::printf ( "\n" );
+        }
+    }
+
+    [[ maybe_unused ]] inline bool run ( const index_t size_, const index_t no_threads_, const index_t log2_tt_size_ ) {
+        switch ( size_ ) {
+            case 4: run<4> ( no_threads_, log2_tt_size_ ); return true;
+            case 5: run<5> ( no_threads_, log2_tt_size_ ); return true;
+            case 6: run<6> ( no_threads_, log2_tt_size_ ); return true;
+            case 7: run<7> ( no_threads_, log2_tt_size_ ); return true;
+            case 8: run<8> ( no_threads_, log2_tt_size_ ); return true;
+            default: return false;
+        }
+    }
+}
@@ -0,0 +1,489 @@
+
+// MIT License
+//
+// Copyright (c) 2018 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined ( _WIN32 )
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "Typedefs.hpp"
+#include "Globals.hpp"
+#include "player.hpp"
+#include "Oska.hpp"
+
+
+// Endgame tablebase.
+//
+// The stones only move forward, so the game has no cycles and positions with few stones can be
+// solved exactly. The generator solves all positions with 1 to K stones per player, in order of
+// the number of stones and, for equal number of stones, of decreasing advancement, as the
+// children of a position have either fewer stones or the same stones further advanced. The
+// positions of one such layer don't depend on one another and are solved in parallel. The
+// result, win, draw or loss for the player to move, is written with 2 bits per position, the
+// file is memory mapped for probing.
+
+namespace tb {
+
+    enum WDL : std::uint8_t { Unknown = 0, Loss, Draw, Win }; // From the perspective of the player to move.
+
+    [[ nodiscard ]] constexpr WDL flip ( const WDL v_ ) noexcept {
+        return v_ == Unknown ? Unknown : WDL ( 4 - v_ );
+    }
+
+
+    // Read-only memory mapped file.
+
+    class MappedFile {
+
+        const std::uint8_t * m_data = nullptr;
+        std::size_t m_size = 0;
+
+#if defined ( _WIN32 )
+        HANDLE m_file = INVALID_HANDLE_VALUE, m_mapping = nullptr;
+#endif
+
+    public:
+
+        MappedFile ( ) noexcept {
+        }
+        MappedFile ( const MappedFile & ) = delete;
+
+        ~MappedFile ( ) noexcept {
+            close ( );
+        }
+
+        MappedFile & operator = ( const MappedFile & ) = delete;
+
+        [[ nodiscard ]] bool open ( const fs::path & path_ ) noexcept {
+            close ( );
+#if defined ( _WIN32 )
+            m_file = CreateFileW ( path_.c_str ( ), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+            LARGE_INTEGER size;
+            if ( m_file == INVALID_HANDLE_VALUE or not ( GetFileSizeEx ( m_file, & size ) ) or not ( size.QuadPart ) ) {
+                close ( );
+                return false;
+            }
+            m_mapping = CreateFileMappingW ( m_file, nullptr, PAGE_READONLY, 0, 0, nullptr );
+            if ( m_mapping == nullptr ) {
+                close ( );
+                return false;
+            }
+            m_data = ( const std::uint8_t * ) MapViewOfFile ( m_mapping, FILE_MAP_READ, 0, 0, 0 );
+            if ( m_data == nullptr ) {
+                close ( );
+                return false;
+            }
+            m_size = ( std::size_t ) size.QuadPart;
+#else
+            const int fd = ::open ( path_.c_str ( ), O_RDONLY );
+            if ( fd < 0 ) {
+                return false;
+            }
+            struct stat st;
+            if ( fstat ( fd, & st ) or not ( st.st_size ) ) {
+                ::close ( fd );
+                return false;
+            }
+            void * data = mmap ( nullptr, ( std::size_t ) st.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+            ::close ( fd );
+            if ( data == MAP_FAILED ) {
+                return false;
+            }
+            m_data = ( const std::uint8_t * ) data, m_size = ( std::size_t ) st.st_size;
+#endif
+            return true;
+        }
+
+        void close ( ) noexcept {
+#if defined ( _WIN32 )
+            if ( m_data != nullptr ) {
+                UnmapViewOfFile ( m_data );
+            }
+            if ( m_mapping != nullptr ) {
+                CloseHandle ( m_mapping );
+            }
+            if ( m_file != INVALID_HANDLE_VALUE ) {
+                CloseHandle ( m_file );
+            }
+            m_mapping = nullptr, m_file = INVALID_HANDLE_VALUE;
+#else
+            if ( m_data != nullptr ) {
+                munmap ( ( void * ) m_data, m_size );
+            }
+#endif
+            m_data = nullptr, m_size = 0;
+        }
+
+        [[ nodiscard ]] const std::uint8_t * data ( ) const noexcept {
+            return m_data;
+        }
+
+        [[ nodiscard ]] std::size_t size ( ) const noexcept {
+            return m_size;
+        }
+    };
+
+
+    template<index_t S>
+    class Tablebase {
+
+    public:
+
+        using Geometry = bb::Geometry<S>;
+        using Bitboard = typename Geometry::Bitboard;
+
+        static constexpr index_t no_hexagons = Geometry::no_hexagons, max_stones = S;
+
+    private:
+
+        static constexpr const typename Geometry::Tables & g = Geometry::tables;
+
+        struct Header { // 16
+            char m_magic [ 8 ];
+            std::int32_t m_size, m_max_stones;
+        };
+
+        static constexpr char magic [ 8 ] = "oskawdl";
+
+        using Binomials = std::array<std::array<std::uint64_t, max_stones + 1>, no_hexagons + 1>;
+        using Ranks = std::array<std::int8_t, Geometry::no_bits>;
+
+        [[ nodiscard ]] static constexpr Binomials buildBinomials ( ) noexcept {
+            Binomials b { };
+            for ( index_t n = 0; n <= no_hexagons; ++n ) {
+                b [ n ] [ 0 ] = 1;
+                for ( index_t k = 1; k <= max_stones; ++k ) {
+                    b [ n ] [ k ] = n ? b [ n - 1 ] [ k - 1 ] + b [ n - 1 ] [ k ] : 0;
+                }
+            }
+            return b;
+        }
+
+        [[ nodiscard ]] static constexpr Ranks buildRanks ( ) noexcept {
+            // The rank of a bit amongst the bits of the board, so that the hexagons are numbered
+            // densely and in the order in which they are found by bb::lsb ( ).
+            Ranks r { };
+            std::int8_t n = 0;
+            for ( index_t b = 0; b < Geometry::no_bits; ++b ) {
+                r [ b ] = g.bit_to_id [ b ] < 0 ? -1 : n++;
+            }
+            return r;
+        }
+
+        static constexpr Binomials binomial = buildBinomials ( );
+        static constexpr Ranks rank = buildRanks ( );
+
+        // Positions with a agent stones and h human stones (1 to K each) are stored in block
+        // [ a ] [ h ], by the combinatorial rank of the agent stones, of the human stones and by
+        // player to move. Positions with overlapping stones are unused.
+
+        struct Layout {
+
+            index_t m_max_stones = 0;
+            std::size_t m_offset [ max_stones + 1 ] [ max_stones + 1 ] { }, m_size = 0;
+
+            Layout ( ) noexcept {
+            }
+            explicit Layout ( const index_t max_stones_ ) noexcept : m_max_stones ( max_stones_ ) {
+                for ( index_t a = 1; a <= m_max_stones; ++a ) {
+                    for ( index_t h = 1; h <= m_max_stones; ++h ) {
+                        m_offset [ a ] [ h ] = m_size;
+                        m_size += 2 * binomial [ no_hexagons ] [ a ] * binomial [ no_hexagons ] [ h ];
+                    }
+                }
+            }
+
+            [[ nodiscard ]] std::size_t bytes ( ) const noexcept {
+                return ( m_size + 3 ) / 4;
+            }
+        };
+
+        [[ nodiscard ]] static std::uint64_t combinationRank ( Bitboard b_ ) noexcept {
+            std::uint64_t r = 0;
+            for ( index_t i = 1; b_; b_ = bb::reset_lsb ( b_ ), ++i ) {
+                r += binomial [ rank [ bb::lsb ( b_ ) ] ] [ i ];
+            }
+            return r;
+        }
+
+        [[ nodiscard ]] static Bitboard combination ( std::uint64_t r_, const index_t k_ ) noexcept {
+            // Inverse of combinationRank ( ).
+            static std::array<std::int8_t, no_hexagons> bit = [ ] ( ) {
+                std::array<std::int8_t, no_hexagons> t { };
+                for ( index_t b = 0; b < Geometry::no_bits; ++b ) {
+                    if ( rank [ b ] >= 0 ) {
+                        t [ rank [ b ] ] = ( std::int8_t ) b;
+                    }
+                }
+                return t;
+            } ( );
+            Bitboard c { };
+            index_t n = no_hexagons;
+            for ( index_t i = k_; i > 0; --i ) {
+                while ( binomial [ --n ] [ i ] > r_ );
+                r_ -= binomial [ n ] [ i ];
+                c |= bb::bit<Bitboard> ( bit [ n ] );
+            }
+            return c;
+        }
+
+        [[ nodiscard ]] static std::size_t index ( const Layout & layout_, const Bitboard ( & stones_ ) [ 2 ], const index_t p_ ) noexcept {
+            // Index of the position, or layout_.m_size if it's not covered.
+            const index_t a = bb::popcount ( stones_ [ 0 ] ), h = bb::popcount ( stones_ [ 1 ] );
+            if ( not ( a ) or not ( h ) or a > layout_.m_max_stones or h > layout_.m_max_stones ) {
+                return layout_.m_size;
+            }
+            return layout_.m_offset [ a ] [ h ] + 2 * ( combinationRank ( stones_ [ 0 ] ) * binomial [ no_hexagons ] [ h ] + combinationRank ( stones_ [ 1 ] ) ) + p_;
+        }
+
+        static MappedFile s_file;
+        static Layout s_layout;
+        static const std::uint8_t * s_data;
+
+    public:
+
+        [[ nodiscard ]] static fs::path fileName ( ) {
+            return fs::path ( "oska-" + std::to_string ( S ) + ".wdl" );
+        }
+
+        [[ nodiscard ]] static bool isLoaded ( ) noexcept {
+            return s_data != nullptr;
+        }
+
+        [[ nodiscard ]] static index_t maxStones ( ) noexcept {
+            return s_layout.m_max_stones;
+        }
+
+        [[ nodiscard ]] static WDL probe ( const Bitboard ( & stones_ ) [ 2 ], const index_t p_ ) noexcept {
+            if ( s_data == nullptr ) {
+                return Unknown;
+            }
+            const std::size_t i = index ( s_layout, stones_, p_ );
+            return i < s_layout.m_size ? WDL ( ( s_data [ i >> 2 ] >> ( 2 * ( i & 3 ) ) ) & 3 ) : Unknown;
+        }
+
+        [[ nodiscard ]] static Player winner ( const Bitboard ( & stones_ ) [ 2 ], const Player player_to_move_ ) noexcept {
+            // Player::Type::invalid if the position is not in the tablebase.
+            switch ( probe ( stones_, player_to_move_.as_01index ( ) ) ) {
+                case Win: return player_to_move_;
+                case Loss: return player_to_move_.opponent ( );
+                case Draw: return Player::Type::vacant;
+                default: return Player::Type::invalid;
+            }
+        }
+
+        [[ nodiscard ]] static bool load ( const fs::path & path_ ) noexcept {
+            s_data = nullptr;
+            if ( not ( s_file.open ( path_ ) ) or s_file.size ( ) < sizeof ( Header ) ) {
+                s_file.close ( );
+                return false;
+            }
+            Header header;
+            std::memcpy ( & header, s_file.data ( ), sizeof ( Header ) );
+            const Layout layout ( std::clamp ( header.m_max_stones, 1, max_stones ) );
+            if ( std::memcmp ( header.m_magic, magic, sizeof ( magic ) ) or header.m_size != S or header.m_max_stones != layout.m_max_stones or s_file.size ( ) != sizeof ( Header ) + layout.bytes ( ) ) {
+                s_file.close ( );
+                return false;
+            }
+            s_layout = layout;
+            s_data = s_file.data ( ) + sizeof ( Header );
+            return true;
+        }
+
+        static void unload ( ) noexcept {
+            s_data = nullptr;
+            s_file.close ( );
+        }
+
+    private:
+
+        [[ nodiscard ]] static WDL solve ( const Layout & layout_, const std::vector<WDL> & values_, const OskaBitStateTemplate<S> & state_ ) noexcept {
+            // The children are either terminal or have been solved.
+            const index_t p = state_.m_player_to_move.as_01index ( );
+            const typename OskaBitStateTemplate<S>::Sources s = state_.sources ( p );
+            WDL best = Unknown;
+            for ( index_t d = Geometry::StepLeft; d <= Geometry::JumpRight; ++d ) {
+                for ( Bitboard b = s.m_stones [ d ]; b; b = bb::reset_lsb ( b ) ) {
+                    const index_t f = bb::lsb ( b );
+                    OskaBitStateTemplate<S> child ( state_ );
+                    child.template moveStone<false> ( p, f, OskaBitStateTemplate<S>::target ( p, d, f ), OskaBitStateTemplate<S>::captured ( p, d, f ) );
+                    child.winner ( );
+                    WDL v;
+                    if ( child.m_winner == Player::Type::invalid ) {
+                        v = flip ( values_ [ index ( layout_, child.m_stones, p ^ 1 ) ] );
+                    }
+                    else {
+                        v = child.m_winner.vacant ( ) ? Draw : ( child.m_winner == state_.m_player_to_move ? Win : Loss );
+                    }
+                    if ( ( best = std::max ( best, v ) ) == Win ) {
+                        return Win;
+                    }
+                }
+            }
+            // Without moves (not reachable), the player to move has won, as OskaBitStateTemplate::winner ( ).
+            return best == Unknown ? Win : best;
+        }
+
+    public:
+
+        // Solve all positions with up to max_stones_ stones per player and write them to path_.
+
+        [[ nodiscard ]] static bool generate ( const index_t max_stones_, const fs::path & path_, index_t no_threads_ = 0 ) {
+            const Layout layout ( std::clamp ( max_stones_, 1, max_stones ) );
+            if ( no_threads_ < 1 ) {
+                no_threads_ = std::max ( 1, ( index_t ) getNumberOfProcessors ( ) );
+            }
+            std::vector<WDL> values ( layout.m_size, Unknown );
+            // The stones, and their advancement, by number of stones and combinatorial rank.
+            std::vector<std::vector<Bitboard>> stones ( layout.m_max_stones + 1 );
+            std::vector<std::vector<index_t>> advancement [ 2 ];
+            advancement [ 0 ].resize ( layout.m_max_stones + 1 ), advancement [ 1 ].resize ( layout.m_max_stones + 1 );
+            for ( index_t k = 1; k <= layout.m_max_stones; ++k ) {
+                for ( std::uint64_t r = 0; r < binomial [ no_hexagons ] [ k ]; ++r ) {
+                    const Bitboard c = combination ( r, k );
+                    index_t agent = 0, human = 0;
+                    for ( Bitboard b = c; b; b = bb::reset_lsb ( b ) ) {
+                        const index_t row = g.bit_to_cell [ bb::lsb ( b ) ].r;
+                        agent += row, human += ( OB_ROWS ( S ) - 1 ) - row;
+                    }
+                    stones [ k ].push_back ( c );
+                    advancement [ 0 ] [ k ].push_back ( agent );
+                    advancement [ 1 ] [ k ].push_back ( human );
+                }
+            }
+            const index_t max_advancement = 2 * layout.m_max_stones * OB_ROWS ( S );
+            for ( index_t n = 2; n <= 2 * layout.m_max_stones; ++n ) {
+                for ( index_t a = std::max ( 1, n - layout.m_max_stones ); a <= std::min ( layout.m_max_stones, n - 1 ); ++a ) {
+                    const index_t h = n - a;
+                    const std::size_t no_h = binomial [ no_hexagons ] [ h ];
+                    // The (non-overlapping) stone pairs of block [ a ] [ h ], by advancement.
+                    std::vector<std::vector<std::size_t>> layers ( max_advancement + 1 );
+                    for ( std::size_t i = 0; i < stones [ a ].size ( ); ++i ) {
+                        for ( std::size_t j = 0; j < no_h; ++j ) {
+                            if ( not ( stones [ a ] [ i ] & stones [ h ] [ j ] ) ) {
+                                layers [ advancement [ 0 ] [ a ] [ i ] + advancement [ 1 ] [ h ] [ j ] ].push_back ( i * no_h + j );
+                            }
+                        }
+                    }
+                    for ( auto layer = layers.crbegin ( ); layer != layers.crend ( ); ++layer ) {
+                        std::atomic<std::size_t> next = 0;
+                        auto work = [ & ] ( ) {
+                            constexpr std::size_t chunk = 1'024;
+                            for ( std::size_t begin = next.fetch_add ( chunk ); begin < layer->size ( ); begin = next.fetch_add ( chunk ) ) {
+                                const std::size_t end = std::min ( begin + chunk, layer->size ( ) );
+                                for ( std::size_t e = begin; e < end; ++e ) {
+                                    const std::size_t q = ( * layer ) [ e ];
+                                    OskaBitStateTemplate<S> state;
+                                    state.m_stones [ 0 ] = stones [ a ] [ q / no_h ];
+                                    state.m_stones [ 1 ] = stones [ h ] [ q % no_h ];
+                                    for ( index_t p = 0; p < 2; ++p ) {
+                                        state.m_player_to_move = p ? Player::Type::human : Player::Type::agent;
+                                        values [ layout.m_offset [ a ] [ h ] + 2 * q + p ] = solve ( layout, values, state );
+                                    }
+                                }
+                            }
+                        };
+                        std::vector<std::thread> threads;
+                        for ( index_t t = 1; t < no_threads_ and t * 4'096 < ( index_t ) layer->size ( ); ++t ) {
+                            threads.emplace_back ( work );
+                        }
+                        work ( );
+                        for ( std::thread & thread : threads ) {
+                            thread.join ( );
+                        }
+                    }
+                }
+            }
+            // Pack and write.
+            std::vector<std::uint8_t> data ( layout.bytes ( ), 0 );
+            for ( std::size_t i = 0; i < layout.m_size; ++i ) {
+                data [ i >> 2 ] |= values [ i ] << ( 2 * ( i & 3 ) );
+            }
+            Header header;
+            std::memcpy ( header.m_magic, magic, sizeof ( magic ) );
+            header.m_size = S, header.m_max_stones = layout.m_max_stones;
+            std::ofstream stream ( path_, std::ios::binary );
+            stream.write ( ( const char * ) & header, sizeof ( Header ) );
+            stream.write ( ( const char * ) data.data ( ), data.size ( ) );
+            return ( bool ) stream;
+        }
+    };
+
+    template<index_t S>
+    MappedFile Tablebase<S>::s_file;
+    template<index_t S>
+    typename Tablebase<S>::Layout Tablebase<S>::s_layout;
+    template<index_t S>
+    const std::uint8_t * Tablebase<S>::s_data = nullptr;
+
+
+    // The default number of stones per player, the size of the tablebase grows as the square of
+    // the number of positions of the stones of one player.
+
+    [[ nodiscard ]] constexpr index_t defaultMaxStones ( const index_t size_ ) noexcept {
+        return size_ < 7 ? 3 : 2;
+    }
+
+    // Load the tablebase for board size size_ from directory_, if it exists.
+
+    [[ maybe_unused ]] inline bool load ( const index_t size_, const fs::path & directory_ ) noexcept {
+        switch ( size_ ) {
+            case 4: return Tablebase<4>::load ( directory_ / Tablebase<4>::fileName ( ) );
+            case 5: return Tablebase<5>::load ( directory_ / Tablebase<5>::fileName ( ) );
+            case 6: return Tablebase<6>::load ( directory_ / Tablebase<6>::fileName ( ) );
+            case 7: return Tablebase<7>::load ( directory_ / Tablebase<7>::fileName ( ) );
+            case 8: return Tablebase<8>::load ( directory_ / Tablebase<8>::fileName ( ) );
+            default: return false;
+        }
+    }
+
+    [[ nodiscard ]] inline bool generate ( const index_t size_, const index_t max_stones_, const fs::path & directory_ ) {
+        switch ( size_ ) {
+            case 4: return Tablebase<4>::generate ( max_stones_, directory_ / Tablebase<4>::fileName ( ) );
+            case 5: return Tablebase<5>::generate ( max_stones_, directory_ / Tablebase<5>::fileName ( ) );
+            case 6: return Tablebase<6>::generate ( max_stones_, directory_ / Tablebase<6>::fileName ( ) );
+            case 7: return Tablebase<7>::generate ( max_stones_, directory_ / Tablebase<7>::fileName ( ) );
+            case 8: return Tablebase<8>::generate ( max_stones_, directory_ / Tablebase<8>::fileName ( ) );
+            default: return false;
+        }
+    }
+}
@@ -71,6 +71,12 @@ public:
         return m_moves [ i_ ];
     }
 
+    [[ nodiscard ]] value_type & operator [ ] ( const index_t i_ ) noexcept {
+        assert ( i_ >= 0 );
+        assert ( i_ < size ( ) );
+        return m_moves [ i_ ];
+    }
+
     [[ nodiscard ]] value_type front ( ) const noexcept {
         return m_moves [ 0 ];
     }
@@ -158,6 +158,10 @@ public:
         seed_ = s_;
     }
 
+    static constexpr result_type at ( uint64_t seed, uint64_t n, uint64_t gamma = 0x9e3779b97f4a7c15 ) { // degski: added this function, the n-th (from 0) output of a generator constructed from seed and gamma, at compile time.
+        return mix64(seed + n * (gamma | 1));
+    }
+
     void advance(uint64_t delta) {
         seed_ += delta * gamma_;
     }
@@ -23,9 +23,13 @@
 
 #pragma once
 
+#if defined ( _WIN32 )
 #define _AMD64_ // For SRWLock...
 #include <windef.h>
 #include <WinBase.h>
+#else
+#include <shared_mutex>
+#endif
 
 
 template < bool L = false >
@@ -33,6 +37,8 @@ struct SRWLock {
 
 };
 
+#if defined ( _WIN32 )
+
 template < >
 struct SRWLock < true > {
 
@@ -54,6 +60,31 @@ private:
 	SRWLOCK srwlock_handle;
 };
 
+#else
+
+template < >
+struct SRWLock < true > { // Elsewhere, the same on a std::shared_mutex.
+
+	void lock ( ) noexcept { m_mutex.lock ( ); }
+	bool tryLock ( ) noexcept { return m_mutex.try_lock ( ); }
+	void unlock ( ) noexcept { m_mutex.unlock ( ); }
+
+	void lockRead ( ) noexcept { m_mutex.lock_shared ( ); }
+	bool tryLockRead ( ) noexcept { return m_mutex.try_lock_shared ( ); }
+	void unlockRead ( ) noexcept { m_mutex.unlock_shared ( ); }
+
+	SRWLock ( ) noexcept { }
+	SRWLock ( const SRWLock < true > & ) noexcept { }
+
+	SRWLock < true > & operator = ( const SRWLock < true > & rhs_ ) { return * this; }
+
+private:
+
+	std::shared_mutex m_mutex;
+};
+
+#endif
+
 template < >
 struct SRWLock < false > {
 
@@ -23,9 +23,14 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <memory>
 #include <mutex> // For std::lock_guard < >.
+#include <new> // For std::align_val_t.
 #include <optional>
+#include <thread> // For std::this_thread::yield ( ).
 #include <type_traits>
 #include <utility> // For std::forward < >.
 
@@ -48,8 +53,10 @@
 
 #define VERSION_12
 
+#if defined ( _MSC_VER )
 #pragma warning ( push )
 #pragma warning ( disable: 4244 )
+#endif
 
 
 // Root: The top node in a tree.
@@ -309,7 +316,7 @@ namespace rt { // Rooted Tree namespace.
 		};
 
 
-		typedef Link < Tree > Link;
+		typedef rt::Link < Tree > Link;
 
 	private:
 
@@ -383,8 +390,8 @@ namespace rt { // Rooted Tree namespace.
 		typedef PaddedType <  UnpaddedArcType < LockAndDataType <  ArcDataType, Locking > > >  ArcType;
 		typedef PaddedType < UnpaddedNodeType < LockAndDataType < NodeDataType, Locking > > > NodeType;
 
-		typedef Lock < Locking > Lock;
-		typedef ScopedLock < Locking > ScopedLock;
+		typedef rt::Lock < Locking > Lock;
+		typedef rt::ScopedLock < Locking > ScopedLock;
 
 
 		// The main data containers...
@@ -577,11 +584,7 @@ namespace rt { // Rooted Tree namespace.
 
 			else {
 
-				char buf [ 64 ] = { };
-
-				_itoa_s ( static_cast < index_t > ( t_ ), buf, 64, 10 );
-
-				return std::string ( buf );
+				return std::to_string ( static_cast < index_t > ( t_ ) );
 			}
 		}
 
@@ -1227,7 +1230,7 @@ namespace rt { // Rooted Tree namespace.
 		typedef typename Graph::Arc   Arc;
 		typedef typename Graph::Node Node;
 
-		typedef Link < Graph > Link;
+		typedef rt::Link < Graph > Link;
 
 		boost::container::deque < Link > m_path;
 
@@ -1276,61 +1279,715 @@ namespace rt { // Rooted Tree namespace.
 	};
 
 
+	// Transposition table, Hash (a Zobrist key) to Data (a Node), open addressing with Robin
+	// Hood probing in a flat, cache line aligned array of ( Hash, Data ) entries. The entries of
+	// a key start at the beginning of a cache line (of entries_per_line entries), a look-up is
+	// one cache miss most of the time. A vacant entry holds Tree::invalid_node. The capacity
+	// is a power of 2 and doubles when the table gets fuller than max_load_factor, the memory
+	// used is 16 bytes times the capacity (for a 64-bit Hash and a 32-bit Data).
+
 	template < typename Tree, typename Hash, typename Data, bool Locking = false >
 	class TranspositionTable {
 
+	public:
+
+		struct value_type { // As std::pair < Hash, Data >.
+
+			Hash first;
+			Data second;
+		};
+
+		static constexpr size_t line_size = 64, entries_per_line = line_size / sizeof ( value_type );
+		static constexpr size_t default_capacity = 1 << 12;
+		static constexpr float max_load_factor = 0.875f;
+
+		static_assert ( line_size % sizeof ( value_type ) == 0, "entries straddle cache lines" );
+
+	private:
+
+		value_type * m_entries = nullptr;
+		size_t m_capacity = 0, m_mask = 0, m_size = 0, m_max_size = 0;
+
+		[[ nodiscard ]] static bool vacant ( const value_type & e_ ) noexcept { return e_.second == Tree::invalid_node; }
+
+		[[ nodiscard ]] size_t home ( const Hash hash_ ) const noexcept { return static_cast < size_t > ( hash_ ) & m_mask & ~( entries_per_line - 1 ); }
+		[[ nodiscard ]] size_t distance ( const size_t i_ ) const noexcept { return ( i_ - home ( m_entries [ i_ ].first ) ) & m_mask; }
+
+		static value_type * allocate ( const size_t capacity_ ) {
+
+			value_type * const entries = static_cast < value_type * > ( ::operator new [ ] ( capacity_ * sizeof ( value_type ), std::align_val_t { line_size } ) );
+
+			for ( size_t i = 0; i < capacity_; ++i ) {
+
+				new ( entries + i ) value_type { Hash ( ), Data ( Tree::invalid_node ) };
+			}
+
+			return entries;
+		}
+
+		static void deallocate ( value_type * const entries_ ) noexcept {
+
+			::operator delete [ ] ( entries_, std::align_val_t { line_size } );
+		}
+
+		void allocate_ ( const size_t capacity_ ) {
+
+			m_entries = allocate ( capacity_ );
+			m_capacity = capacity_;
+			m_mask = capacity_ - 1;
+			m_size = 0;
+			m_max_size = static_cast < size_t > ( max_load_factor * capacity_ );
+		}
+
+		// The entry is not in the table, it goes where it's the richest (the shortest distance
+		// from its home), the entries it passes move up one.
+
+		value_type * insert ( value_type e_ ) noexcept {
+
+			value_type * inserted = nullptr;
+
+			for ( size_t i = home ( e_.first ), d = 0; ; i = ( i + 1 ) & m_mask, ++d ) {
+
+				if ( vacant ( m_entries [ i ] ) ) {
+
+					m_entries [ i ] = e_;
+					++m_size;
+
+					return inserted ? inserted : m_entries + i;
+				}
+
+				const size_t d_i = distance ( i );
+
+				if ( d_i < d ) {
+
+					std::swap ( e_, m_entries [ i ] );
+
+					if ( not ( inserted ) ) {
+
+						inserted = m_entries + i;
+					}
+
+					d = d_i;
+				}
+			}
+		}
+
+		[[ nodiscard ]] size_t index ( const Hash hash_ ) const noexcept { // m_capacity if not found.
+
+			for ( size_t i = home ( hash_ ), d = 0; ; i = ( i + 1 ) & m_mask, ++d ) {
+
+				const value_type & e = m_entries [ i ];
+
+				if ( vacant ( e ) or distance ( i ) < d ) {
+
+					return m_capacity;
+				}
+
+				if ( e.first == hash_ ) {
+
+					return i;
+				}
+			}
+		}
+
+		void rehash ( const size_t capacity_ ) {
+
+			value_type * const entries = m_entries;
+			const size_t capacity = m_capacity;
+
+			allocate_ ( capacity_ );
+
+			for ( size_t i = 0; i < capacity; ++i ) {
+
+				if ( not ( vacant ( entries [ i ] ) ) ) {
+
+					insert ( entries [ i ] );
+				}
+			}
+
+			deallocate ( entries );
+		}
+
+		[[ nodiscard ]] static size_t capacityFor ( const size_t size_ ) noexcept {
+
+			size_t capacity = entries_per_line;
+
+			while ( max_load_factor * capacity < size_ ) {
+
+				capacity <<= 1;
+			}
+
+			return capacity;
+		}
+
+	public:
+
+		template < typename Value >
+		class Iterator { // Forward, over the occupied entries.
+
+			Value * m_entry, * m_end;
+
+			void skip ( ) noexcept {
+
+				while ( m_entry != m_end and vacant ( * m_entry ) ) {
+
+					++m_entry;
+				}
+			}
+
+		public:
+
+			Iterator ( Value * e_, Value * end_ ) noexcept : m_entry ( e_ ), m_end ( end_ ) { skip ( ); }
+
+			Iterator & operator ++ ( ) noexcept { ++m_entry; skip ( ); return * this; }
+
+			Value & operator * ( ) const noexcept { return * m_entry; }
+			Value * operator -> ( ) const noexcept { return m_entry; }
+
+			operator Iterator < const Value > ( ) const noexcept { return Iterator < const Value > ( m_entry, m_end ); }
+
+			template < typename V > bool operator == ( const Iterator < V > & rhs_ ) const noexcept { return m_entry == rhs_.operator -> ( ); }
+			template < typename V > bool operator != ( const Iterator < V > & rhs_ ) const noexcept { return m_entry != rhs_.operator -> ( ); }
+		};
+
+		typedef Iterator < value_type > iterator;
+		typedef Iterator < const value_type > const_iterator;
+
+		explicit TranspositionTable ( const size_t capacity_ = default_capacity ) { allocate_ ( capacityFor ( capacity_ ) ); }
+
+		TranspositionTable ( const TranspositionTable & ) = delete;
+		TranspositionTable & operator = ( const TranspositionTable & ) = delete;
+
+		~TranspositionTable ( ) noexcept { deallocate ( m_entries ); }
+
+		[[ nodiscard ]] size_t size ( ) const noexcept { return m_size; }
+		[[ nodiscard ]] size_t capacity ( ) const noexcept { return m_capacity; }
+
+		// Room for size_ entries, without growing.
+
+		void reserve ( const size_t size_ ) {
+
+			if ( size_ > m_max_size ) {
+
+				rehash ( capacityFor ( size_ ) );
+			}
+		}
+
+		void clear ( ) noexcept {
+
+			for ( size_t i = 0; i < m_capacity; ++i ) {
+
+				m_entries [ i ].second = Tree::invalid_node;
+			}
+
+			m_size = 0;
+		}
+
+		iterator begin ( ) noexcept { return iterator ( m_entries, m_entries + m_capacity ); }
+		iterator end ( ) noexcept { return iterator ( m_entries + m_capacity, m_entries + m_capacity ); }
+		const_iterator begin ( ) const noexcept { return const_iterator ( m_entries, m_entries + m_capacity ); }
+		const_iterator end ( ) const noexcept { return const_iterator ( m_entries + m_capacity, m_entries + m_capacity ); }
+		const_iterator cbegin ( ) const noexcept { return begin ( ); }
+		const_iterator cend ( ) const noexcept { return end ( ); }
+
+		template < typename F >
+		void forEach ( F && f_ ) const { // f_ ( Hash, Data ) for each entry.
+
+			for ( const value_type & e : * this ) {
+
+				f_ ( e.first, e.second );
+			}
+		}
+
+		[[ nodiscard ]] iterator find ( const Hash hash_ ) noexcept { return iterator ( m_entries + index ( hash_ ), m_entries + m_capacity ); }
+		[[ nodiscard ]] const_iterator find ( const Hash hash_ ) const noexcept { return const_iterator ( m_entries + index ( hash_ ), m_entries + m_capacity ); }
+
+		// The Data of hash_, Tree::invalid_node if none.
+
+		[[ nodiscard ]] Data get ( const Hash hash_ ) const noexcept {
+
+			const size_t i = index ( hash_ );
+
+			return i == m_capacity ? Data ( Tree::invalid_node ) : m_entries [ i ].second;
+		}
+
+		// As std::unordered_map::emplace ( ), an entry that exists is not replaced.
+
+		std::pair < iterator, bool > emplace ( const Hash hash_, const Data data_ ) {
+
+			const size_t i = index ( hash_ );
+
+			if ( i != m_capacity ) {
+
+				return { iterator ( m_entries + i, m_entries + m_capacity ), false };
+			}
+
+			if ( m_size == m_max_size ) {
+
+				rehash ( m_capacity << 1 );
+			}
+
+			return { iterator ( insert ( value_type { hash_, data_ } ), m_entries + m_capacity ), true };
+		}
+
+		// Backward shift deletion, the entries after it (up to a vacant one or one at its home)
+		// move down one.
+
+		size_t erase ( const Hash hash_ ) noexcept {
+
+			size_t i = index ( hash_ );
+
+			if ( i == m_capacity ) {
+
+				return 0;
+			}
+
+			for ( size_t j = ( i + 1 ) & m_mask; not ( vacant ( m_entries [ j ] ) ) and distance ( j ) > 0; i = j, j = ( j + 1 ) & m_mask ) {
+
+				m_entries [ i ] = m_entries [ j ];
+			}
+
+			m_entries [ i ].second = Tree::invalid_node;
+			--m_size;
+
+			return 1;
+		}
+
+		// The Data of each entry becomes f_ ( Data ), an entry that maps to Tree::invalid_node is
+		// erased (the nodes of a pruned tree), in one pass over the entries, the keys are kept.
+
+		template < typename F >
+		void remap ( F && f_ ) {
+
+			value_type * const entries = m_entries;
+			const size_t capacity = m_capacity;
+
+			allocate_ ( capacity );
+
+			for ( size_t i = 0; i < capacity; ++i ) {
+
+				if ( not ( vacant ( entries [ i ] ) ) ) {
+
+					const Data data = f_ ( entries [ i ].second );
+
+					if ( data != Tree::invalid_node ) {
+
+						insert ( value_type { entries [ i ].first, data } );
+					}
+				}
+			}
+
+			deallocate ( entries );
+		}
+
+	private:
+
+		friend class cereal::access;
+
+		template < class Archive >
+		void save ( Archive & ar_ ) const {
+
+			ar_ ( m_size );
+
+			for ( const value_type & e : * this ) {
+
+				ar_ ( e.first, e.second );
+			}
+		}
+
+		template < class Archive >
+		void load ( Archive & ar_ ) {
+
+			size_t size;
+
+			ar_ ( size );
+
+			clear ( );
+			reserve ( size );
+
+			for ( size_t i = 0; i < size; ++i ) {
+
+				Hash hash; Data data;
+
+				ar_ ( hash, data );
+
+				emplace ( hash, data );
+			}
+		}
 	};
 
+
+	// Concurrent transposition table, lock-free look-ups and an atomic insert_or_get ( ), of which
+	// one thread only creates the Data of a key (two threads expanding the same transposition
+	// get the same node). Open addressing with linear probing, an entry is claimed by a CAS of
+	// its key, the Data is published after it's created. Entries never become vacant again, a
+	// key is always before the first vacant (or sealed) entry of its probe. A table that gets
+	// fuller than max_load_factor is sealed, a key probing it claims that vacant entry as sealed
+	// and goes on in the next table (of growth times the capacity), as does a key that meets a
+	// sealed entry, or with a probe of more than max_probe entries. The chain of tables is folded
+	// into one by reserve ( ) (not concurrent), between searches. The keys 0 and 1 mark the vacant
+	// and the sealed entries, the hashes 0 and 1 have an entry of their own (m_reserved), outside
+	// the tables, every hash has a key of its own.
+
 	template < typename Tree, typename Hash, typename Data >
 	class TranspositionTable < Tree, Hash, Data, true > {
 
-		typedef tbb::concurrent_unordered_map < Hash, Data > transposistion_table_t;
+	public:
+
+		static constexpr size_t line_size = 64;
+		static constexpr size_t default_capacity = 1 << 12;
+		static constexpr size_t max_probe = 32, growth = 4;
+		static constexpr float max_load_factor = 0.75f;
+
+	private:
+
+		static constexpr Hash vacant_key = 0, sealed_key = 1;
+
+		struct Entry { // 16
+
+			std::atomic < Hash > m_key { vacant_key };
+			std::atomic < index_t > m_data { Tree::invalid_node ( ) }; // Tree::invalid_node while the Data is being created.
+		};
+
+		static constexpr size_t entries_per_line = line_size / sizeof ( Entry );
+
+		struct alignas ( line_size ) Line {
+
+			Entry m_entries [ entries_per_line ];
+		};
+
+		struct Table {
+
+			std::unique_ptr < Line [ ] > m_lines;
+			const size_t m_mask, m_max_size;
+			std::atomic < size_t > m_size { 0 };
+			std::atomic < Table * > m_next { nullptr };
+
+			explicit Table ( const size_t capacity_ ) :
+				m_lines ( new Line [ capacity_ / entries_per_line ] ), m_mask ( capacity_ - 1 ), m_max_size ( static_cast < size_t > ( max_load_factor * capacity_ ) ) { }
+
+			~Table ( ) noexcept { delete m_next.load ( std::memory_order_relaxed ); }
+
+			[[ nodiscard ]] size_t capacity ( ) const noexcept { return m_mask + 1; }
+
+			Entry & entry ( const size_t i_ ) noexcept { return m_lines [ i_ / entries_per_line ].m_entries [ i_ % entries_per_line ]; }
+			Entry const & entry ( const size_t i_ ) const noexcept { return m_lines [ i_ / entries_per_line ].m_entries [ i_ % entries_per_line ]; }
+		};
+
+		std::unique_ptr < Table > m_table;
+		Entry m_reserved [ 2 ]; // Of the hashes vacant_key and sealed_key, claimed by a key of sealed_key.
+
+		[[ nodiscard ]] static Data published ( const Entry & e_ ) noexcept {
+
+			index_t data;
+
+			while ( ( data = e_.m_data.load ( std::memory_order_acquire ) ) == Tree::invalid_node ( ) ) {
+
+				std::this_thread::yield ( );
+			}
+
+			return Data ( data );
+		}
+
+		[[ nodiscard ]] static size_t capacityFor ( const size_t size_ ) noexcept {
+
+			size_t capacity = entries_per_line;
+
+			while ( max_load_factor * capacity < size_ ) {
+
+				capacity <<= 1;
+			}
+
+			return capacity;
+		}
+
+		[[ nodiscard ]] static Table * next ( Table * const table_ ) {
+
+			Table * next = table_->m_next.load ( std::memory_order_acquire );
+
+			if ( next == nullptr ) {
+
+				Table * const table = new Table ( table_->capacity ( ) * growth );
+
+				if ( table_->m_next.compare_exchange_strong ( next, table, std::memory_order_acq_rel, std::memory_order_acquire ) ) {
+
+					next = table;
+				}
+
+				else {
+
+					delete table;
+				}
+			}
+
+			return next;
+		}
+
+	public:
+
+		explicit TranspositionTable ( const size_t capacity_ = default_capacity ) : m_table ( new Table ( capacityFor ( capacity_ ) ) ) { }
 
-		transposistion_table_t m_table;
+		TranspositionTable ( const TranspositionTable & ) = delete;
+		TranspositionTable & operator = ( const TranspositionTable & ) = delete;
 
-		template < typename Hash, typename ... Args >
-		void emplace ( const Hash hash_, Args && ... args_ ) noexcept {
+		[[ nodiscard ]] size_t size ( ) const noexcept {
 
-			m_table.emplace ( std::make_pair ( hash_, Data ( std::forward < Args > ( args_ ) ... ) ) );
+			size_t size = 0;
+
+			for ( const Table * t = m_table.get ( ); t != nullptr; t = t->m_next.load ( std::memory_order_acquire ) ) {
+
+				size += t->m_size.load ( std::memory_order_relaxed );
+			}
+
+			for ( const Entry & e : m_reserved ) {
+
+				size += e.m_key.load ( std::memory_order_relaxed ) != vacant_key;
+			}
+
+			return size;
 		}
 
-		std::pair < Hash, Data > record ( const Hash hash_ ) const noexcept {
+		[[ nodiscard ]] size_t capacity ( ) const noexcept {
 
-			const auto it = m_table.find ( hash_ );
+			size_t capacity = 0;
 
-			if ( it != m_table.end ( ) ) {
+			for ( const Table * t = m_table.get ( ); t != nullptr; t = t->m_next.load ( std::memory_order_acquire ) ) {
 
-				return * it;
+				capacity += t->capacity ( );
 			}
 
-			return std::make_pair ( hash_, Data ( Tree::invalid_node ) );
+			return capacity;
 		}
 
-		std::optional < Data & > get ( const Hash hash_ ) noexcept {
+		template < typename F >
+		void forEach ( F && f_ ) const { // Not concurrent, f_ ( Hash, Data ) for each entry.
 
-			const auto it = m_table.find ( hash_ );
+			for ( Hash h = vacant_key; h <= sealed_key; ++h ) {
 
-			if ( it != m_table.end ( ) ) {
+				if ( m_reserved [ h ].m_key.load ( std::memory_order_relaxed ) != vacant_key ) {
 
-				return boost::make_optional < Data & > ( it->second );
+					f_ ( h, Data ( m_reserved [ h ].m_data.load ( std::memory_order_relaxed ) ) );
+				}
 			}
 
-			return boost::make_optional < Data & > ( );
+			for ( const Table * t = m_table.get ( ); t != nullptr; t = t->m_next.load ( std::memory_order_relaxed ) ) {
+
+				for ( size_t i = 0; i < t->capacity ( ); ++i ) {
+
+					const Entry & e = t->entry ( i );
+
+					if ( e.m_key.load ( std::memory_order_relaxed ) > sealed_key ) {
+
+						f_ ( e.m_key.load ( std::memory_order_relaxed ), Data ( e.m_data.load ( std::memory_order_relaxed ) ) );
+					}
+				}
+			}
 		}
 
-		Data const & get ( const Hash hash_ ) const noexcept {
+		// The Data of hash_, Tree::invalid_node if none (or if it's still being created), lock-free.
+
+		[[ nodiscard ]] Data get ( const Hash hash_ ) const noexcept {
+
+			if ( hash_ <= sealed_key ) {
+
+				return Data ( m_reserved [ hash_ ].m_data.load ( std::memory_order_acquire ) );
+			}
+
+			const Hash key = hash_;
+
+			for ( const Table * t = m_table.get ( ); t != nullptr; t = t->m_next.load ( std::memory_order_acquire ) ) {
+
+				for ( size_t i = key & t->m_mask, d = 0; d < max_probe; i = ( i + 1 ) & t->m_mask, ++d ) {
 
-			const auto it = m_table.find ( hash_ );
+					const Entry & e = t->entry ( i );
+					const Hash k = e.m_key.load ( std::memory_order_acquire );
 
-			if ( it != m_table.end ( ) ) {
+					if ( k == key ) {
 
-				return it->second;
+						return Data ( e.m_data.load ( std::memory_order_acquire ) );
+					}
+
+					if ( k == vacant_key ) {
+
+						return Data ( Tree::invalid_node );
+					}
+
+					if ( k == sealed_key ) {
+
+						break;
+					}
+				}
 			}
 
 			return Data ( Tree::invalid_node );
 		}
+
+		// The Data of hash_, and true if it was created by create_ ( ) of this call, or the Data
+		// created by (waiting for) the thread that claimed hash_ first, and false.
+
+		template < typename F >
+		std::pair < Data, bool > insert_or_get ( const Hash hash_, F && create_ ) {
+
+			if ( hash_ <= sealed_key ) {
+
+				Entry & e = m_reserved [ hash_ ];
+				Hash k = vacant_key;
+
+				if ( e.m_key.compare_exchange_strong ( k, sealed_key, std::memory_order_acq_rel, std::memory_order_acquire ) ) {
+
+					const Data data = create_ ( );
+
+					e.m_data.store ( data ( ), std::memory_order_release );
+
+					return { data, true };
+				}
+
+				return { published ( e ), false };
+			}
+
+			const Hash key = hash_;
+
+			for ( Table * t = m_table.get ( ); ; t = next ( t ) ) {
+
+				const bool is_sealed = t->m_size.load ( std::memory_order_relaxed ) >= t->m_max_size;
+
+				for ( size_t i = key & t->m_mask, d = 0; d < max_probe; i = ( i + 1 ) & t->m_mask, ++d ) {
+
+					Entry & e = t->entry ( i );
+					Hash k = e.m_key.load ( std::memory_order_acquire );
+
+					if ( k == vacant_key ) {
+
+						if ( e.m_key.compare_exchange_strong ( k, is_sealed ? sealed_key : key, std::memory_order_acq_rel, std::memory_order_acquire ) ) {
+
+							if ( is_sealed ) {
+
+								break;
+							}
+
+							t->m_size.fetch_add ( 1, std::memory_order_relaxed );
+
+							const Data data = create_ ( );
+
+							e.m_data.store ( data ( ), std::memory_order_release );
+
+							return { data, true };
+						}
+
+						// Claimed by another thread, k is its key.
+					}
+
+					if ( k == sealed_key ) {
+
+						break;
+					}
+
+					if ( k == key ) {
+
+						return { published ( e ), false };
+					}
+				}
+			}
+		}
+
+		bool emplace ( const Hash hash_, const Data data_ ) {
+
+			return insert_or_get ( hash_, [ data_ ] ( ) { return data_; } ).second;
+		}
+
+		// Not concurrent, room for size_ entries in one table, the chain of tables is folded into it.
+
+		void reserve ( const size_t size_ ) {
+
+			if ( capacity ( ) != m_table->capacity ( ) or size_ > m_table->m_max_size ) { // A chain of tables, or too small.
+
+				TranspositionTable source ( 0 );
+
+				source.m_table = std::move ( m_table );
+				m_table.reset ( new Table ( capacityFor ( std::max ( size_, source.size ( ) ) ) ) );
+				source.forEach ( [ this ] ( const Hash key_, const Data data_ ) { emplace ( key_, data_ ); } );
+			}
+		}
+
+		// Not concurrent.
+
+		void clear ( ) {
+
+			m_table.reset ( new Table ( m_table->capacity ( ) ) );
+
+			for ( Entry & e : m_reserved ) {
+
+				e.m_key.store ( vacant_key, std::memory_order_relaxed );
+				e.m_data.store ( Tree::invalid_node ( ), std::memory_order_relaxed );
+			}
+		}
+
+		// Not concurrent, as the non-locking TranspositionTable::remap ( ).
+
+		template < typename F >
+		void remap ( F && f_ ) {
+
+			TranspositionTable source ( 0 );
+
+			source.m_table = std::move ( m_table );
+			m_table.reset ( new Table ( source.m_table->capacity ( ) ) );
+			source.forEach ( [ this, & f_ ] ( const Hash key_, const Data data_ ) {
+
+				const Data data = f_ ( data_ );
+
+				if ( data != Tree::invalid_node ) {
+
+					emplace ( key_, data );
+				}
+			} );
+
+			for ( Entry & e : m_reserved ) {
+
+				if ( e.m_key.load ( std::memory_order_relaxed ) != vacant_key ) {
+
+					const Data data = f_ ( Data ( e.m_data.load ( std::memory_order_relaxed ) ) );
+
+					e.m_key.store ( data != Tree::invalid_node ? sealed_key : vacant_key, std::memory_order_relaxed );
+					e.m_data.store ( data ( ), std::memory_order_relaxed );
+				}
+			}
+		}
+
+	private:
+
+		friend class cereal::access;
+
+		template < class Archive >
+		void save ( Archive & ar_ ) const {
+
+			ar_ ( size ( ) );
+
+			forEach ( [ & ar_ ] ( const Hash key_, const Data data_ ) { ar_ ( key_, data_ ); } );
+		}
+
+		template < class Archive >
+		void load ( Archive & ar_ ) {
+
+			size_t size;
+
+			ar_ ( size );
+
+			clear ( );
+			reserve ( size );
+
+			for ( size_t i = 0; i < size; ++i ) {
+
+				Hash hash; Data data;
+
+				ar_ ( hash, data );
+
+				emplace ( hash, data );
+			}
+		}
 	};
 
 } // Rooted Tree namespace...
 
+#if defined ( _MSC_VER )
 #pragma warning ( pop )
+#endif